@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include <vector>
+#include <cstddef>
+
+// Lock-free bounded multi-producer/multi-consumer queue (Vyukov). The
+// capacity is rounded up to a power of two. try_push fails when full and
+// try_pop fails when empty; callers decide whether to spin, yield or drop.
+template <typename T>
+class BoundedQueue {
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+public:
+    explicit BoundedQueue(size_t capacity) : m_cells(round_up(capacity)) {
+        m_mask = m_cells.size() - 1;
+        for (size_t i = 0; i < m_cells.size(); ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        m_enqueue_pos.store(0, std::memory_order_relaxed);
+        m_dequeue_pos.store(0, std::memory_order_relaxed);
+    }
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    size_t capacity() const {
+        return m_cells.size();
+    }
+
+    bool try_push(const T &value) {
+        Cell *cell;
+        size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)pos;
+            if (diff == 0) {
+                if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T &value) {
+        Cell *cell;
+        size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)(pos + 1);
+            if (diff == 0) {
+                if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        // Reset the cell so it does not keep the payload alive until overwritten.
+        value = std::move(cell->data);
+        cell->data = T();
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static size_t round_up(size_t capacity) {
+        size_t n = 2;
+        while (n < capacity) {
+            n <<= 1;
+        }
+        return n;
+    }
+
+    static const size_t cache_line_size = 64;
+
+    // Keep producers and consumers off each other's cache line. Padding
+    // rather than alignas, so owners stay ordinarily aligned for new.
+    std::vector<Cell> m_cells;
+    size_t m_mask;
+    char m_pad0[cache_line_size];
+    std::atomic<size_t> m_enqueue_pos;
+    char m_pad1[cache_line_size - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> m_dequeue_pos;
+    char m_pad2[cache_line_size - sizeof(std::atomic<size_t>)];
+};
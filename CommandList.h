@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+#include <algorithm>
+
+// Deferred GL work recorded on any thread and replayed on the GL thread.
+// Commands are closures placement-constructed into arena blocks owned by the
+// list; reset() keeps the blocks, so a list reused every frame stops
+// allocating once it has grown to its working size. A list must only be
+// recorded by one thread at a time: give each worker its own list, then
+// replay them in order on the thread owning the context.
+//
+//     worker i:   lists[i].reset();
+//                 lists[i].set_uniform(pass, "model", model);
+//                 lists[i].draw(geometry);
+//     GL thread:  pass->begin(w, h);
+//                 for (auto &list : lists) list.replay();
+//                 pass->end();
+class CommandList {
+    struct Command {
+        void (*run)(Command *);
+        void (*destroy)(Command *);
+        size_t size;
+    };
+
+    template <typename F>
+    struct Closure : Command {
+        F f;
+
+        explicit Closure(F &&function) : f(std::move(function)) {
+            run = [](Command *c) { static_cast<Closure *>(c)->f(); };
+            destroy = [](Command *c) { static_cast<Closure *>(c)->~Closure(); };
+            size = aligned_size(sizeof(Closure));
+        }
+    };
+
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t capacity;
+        size_t used;
+    };
+
+public:
+    explicit CommandList(size_t block_size = 64 << 10) {
+        m_block_size = block_size;
+        m_current = 0;
+        m_count = 0;
+    }
+
+    CommandList(const CommandList &) = delete;
+    CommandList &operator=(const CommandList &) = delete;
+
+    CommandList(CommandList &&other) {
+        take(other);
+    }
+
+    CommandList &operator=(CommandList &&other) {
+        if (this != &other) {
+            // The recorded closures must be destroyed before their blocks go.
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    ~CommandList() {
+        reset();
+    }
+
+    template <typename F>
+    void record(F function) {
+        typedef Closure<F> C;
+        void *storage = allocate(aligned_size(sizeof(C)));
+        new (storage) C(std::move(function));
+        ++m_count;
+    }
+
+    // The name must outlive replay(), e.g. a string literal.
+    template <typename P, typename T>
+    void set_uniform(P *pass, const char *name, const T &value) {
+        record([pass, name, value]() { pass->set_uniform(name, value); });
+    }
+
+    template <typename P>
+    void begin(P *pass, int w, int h) {
+        record([pass, w, h]() { pass->begin(w, h); });
+    }
+
+    template <typename P>
+    void end(P *pass) {
+        record([pass]() { pass->end(); });
+    }
+
+    template <typename G>
+    void draw(G *geometry) {
+        record([geometry]() { geometry->draw(); });
+    }
+
+    void replay() const {
+        for (size_t b = 0; b < m_blocks.size() && b <= m_current; ++b) {
+            const Block &block = m_blocks[b];
+            for (size_t offset = 0; offset < block.used;) {
+                Command *command = (Command *)(block.data.get() + offset);
+                command->run(command);
+                offset += command->size;
+            }
+        }
+    }
+
+    // Destroys the recorded commands but keeps the arena for the next frame.
+    void reset() {
+        for (Block &block : m_blocks) {
+            for (size_t offset = 0; offset < block.used;) {
+                Command *command = (Command *)(block.data.get() + offset);
+                offset += command->size;
+                command->destroy(command);
+            }
+            block.used = 0;
+        }
+        m_current = 0;
+        m_count = 0;
+    }
+
+    size_t size() const {
+        return m_count;
+    }
+
+    size_t reserved_bytes() const {
+        size_t bytes = 0;
+        for (const Block &block : m_blocks) {
+            bytes += block.capacity;
+        }
+        return bytes;
+    }
+
+private:
+    static const size_t alignment = alignof(std::max_align_t);
+
+    static size_t aligned_size(size_t size) {
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    // Leaves other empty but usable.
+    void take(CommandList &other) {
+        m_block_size = other.m_block_size;
+        m_current = other.m_current;
+        m_count = other.m_count;
+        m_blocks = std::move(other.m_blocks);
+        other.m_blocks.clear();
+        other.m_current = 0;
+        other.m_count = 0;
+    }
+
+    void *allocate(size_t size) {
+        while (m_current < m_blocks.size() && m_blocks[m_current].capacity - m_blocks[m_current].used < size) {
+            ++m_current;
+        }
+        if (m_current == m_blocks.size()) {
+            Block block;
+            block.capacity = std::max(m_block_size, size);
+            block.data.reset(new char[block.capacity]);
+            block.used = 0;
+            m_blocks.push_back(std::move(block));
+        }
+        Block &block = m_blocks[m_current];
+        void *storage = block.data.get() + block.used;
+        block.used += size;
+        return storage;
+    }
+
+    size_t m_block_size;
+    size_t m_current;
+    size_t m_count;
+    std::vector<Block> m_blocks;
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include <glm/gtc/packing.hpp>
+
+// Reduced-precision and packed vertex/texel types. They carry no arithmetic,
+// they only exist so that GLTypeTraits can map them to compact GL formats.
+
+struct half {
+    std::uint16_t bits;
+};
+
+struct hvec2 {
+    half x, y;
+};
+
+struct hvec3 {
+    half x, y, z;
+};
+
+struct hvec4 {
+    half x, y, z, w;
+};
+
+// GL_INT_2_10_10_10_REV: x, y, z in 10 bits, w in 2 bits, signed.
+struct int_2_10_10_10_rev {
+    std::uint32_t bits;
+};
+
+// GL_UNSIGNED_INT_2_10_10_10_REV: x, y, z in 10 bits, w in 2 bits, unsigned.
+struct uint_2_10_10_10_rev {
+    std::uint32_t bits;
+};
+
+// GL_UNSIGNED_INT_10F_11F_11F_REV: unsigned floats, 11/11/10 bits.
+struct uint_10f_11f_11f_rev {
+    std::uint32_t bits;
+};
+
+// Integer data which the shader sees as floats in [0, 1] (unsigned) or [-1, 1] (signed).
+template <typename T>
+struct normalized {
+    T value;
+};
+
+template <typename T>
+struct is_normalized : std::false_type {};
+
+template <typename T>
+struct is_normalized<normalized<T>> : std::true_type {};
+
+inline void quantize(float v, half &q) {
+    q.bits = glm::packHalf1x16(v);
+}
+
+inline void quantize(const glm::vec2 &v, hvec2 &q) {
+    quantize(v.x, q.x);
+    quantize(v.y, q.y);
+}
+
+inline void quantize(const glm::vec3 &v, hvec3 &q) {
+    quantize(v.x, q.x);
+    quantize(v.y, q.y);
+    quantize(v.z, q.z);
+}
+
+inline void quantize(const glm::vec4 &v, hvec4 &q) {
+    quantize(v.x, q.x);
+    quantize(v.y, q.y);
+    quantize(v.z, q.z);
+    quantize(v.w, q.w);
+}
+
+// The 2_10_10_10 packings store snorm/unorm values, so they are only
+// produced wrapped in normalized<> and read back in [-1, 1] / [0, 1].
+inline void quantize(const glm::vec4 &v, normalized<int_2_10_10_10_rev> &q) {
+    q.value.bits = glm::packSnorm3x10_1x2(v);
+}
+
+inline void quantize(const glm::vec3 &v, normalized<int_2_10_10_10_rev> &q) {
+    quantize(glm::vec4(v, 0.0f), q);
+}
+
+inline void quantize(const glm::vec4 &v, normalized<uint_2_10_10_10_rev> &q) {
+    q.value.bits = glm::packUnorm3x10_1x2(v);
+}
+
+inline void quantize(const glm::vec3 &v, normalized<uint_2_10_10_10_rev> &q) {
+    quantize(glm::vec4(v, 1.0f), q);
+}
+
+inline void quantize(const glm::vec3 &v, uint_10f_11f_11f_rev &q) {
+    q.bits = glm::packF2x11_1x10(v);
+}
+
+template <typename I>
+inline I quantize_normalized(float v) {
+    // Follows the GL conversion rules: unsigned maps [0, 1] to [0, max],
+    // signed maps [-1, 1] to [-max, max].
+    const float lo = std::numeric_limits<I>::is_signed ? -1.0f : 0.0f;
+    const float c = std::min(std::max(v, lo), 1.0f);
+    return I(std::round(c * float(std::numeric_limits<I>::max())));
+}
+
+template <typename I>
+inline void quantize(float v, normalized<I> &q) {
+    q.value = quantize_normalized<I>(v);
+}
+
+template <typename I>
+inline void quantize(const glm::vec2 &v, normalized<glm::tvec2<I, glm::highp>> &q) {
+    q.value.x = quantize_normalized<I>(v.x);
+    q.value.y = quantize_normalized<I>(v.y);
+}
+
+template <typename I>
+inline void quantize(const glm::vec3 &v, normalized<glm::tvec3<I, glm::highp>> &q) {
+    q.value.x = quantize_normalized<I>(v.x);
+    q.value.y = quantize_normalized<I>(v.y);
+    q.value.z = quantize_normalized<I>(v.z);
+}
+
+template <typename I>
+inline void quantize(const glm::vec4 &v, normalized<glm::tvec4<I, glm::highp>> &q) {
+    q.value.x = quantize_normalized<I>(v.x);
+    q.value.y = quantize_normalized<I>(v.y);
+    q.value.z = quantize_normalized<I>(v.z);
+    q.value.w = quantize_normalized<I>(v.w);
+}
+
+// Converts full-precision attribute data before upload, e.g.
+//     geometry->add_attribute(quantize<normalized<int_2_10_10_10_rev>>(normals));
+template <typename Q, typename T>
+std::vector<Q> quantize(const std::vector<T> &data) {
+    std::vector<Q> result(data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+        quantize(data[i], result[i]);
+    }
+    return result;
+}
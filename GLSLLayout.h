@@ -0,0 +1,245 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+#include "GLTypeTraits.h"
+
+// Compile-time description of a pass interface. The declaration blocks of both
+// shader stages are produced as constexpr strings, and type mismatches between
+// vertex attributes, shader inputs and color attachments fail to compile:
+//
+//     GLSL_NAME(vertex_coord);
+//     GLSL_NAME(frag_color);
+//     typedef ShaderLayout<
+//         vshader_input<0, glm::vec3, vertex_coord>,
+//         fshader_output<glm::vec4, frag_color>
+//     > TriangleLayout;
+//
+//     pass->set_layout<TriangleLayout>();
+//     geometry->add_attribute<TriangleLayout, 0>(points);
+
+#define GLSL_NAME(id) struct id { static constexpr const char *value() { return #id; } }
+
+template <size_t N>
+struct static_string {
+    char data[N + 1];
+
+    static constexpr size_t size() { return N; }
+    constexpr const char *c_str() const { return data; }
+};
+
+constexpr size_t static_strlen(const char *s) {
+    return *s ? 1 + static_strlen(s + 1) : 0;
+}
+
+template <size_t N, size_t... I>
+constexpr static_string<N> make_static_string(const char *s, std::index_sequence<I...>) {
+    return { { s[I]..., '\0' } };
+}
+
+template <size_t N>
+constexpr static_string<N - 1> make_static_string(const char(&s)[N]) {
+    return make_static_string<N - 1>(s, std::make_index_sequence<N - 1>());
+}
+
+// S provides "static constexpr const char *value()".
+template <typename S>
+constexpr static_string<static_strlen(S::value())> make_static_string() {
+    return make_static_string<static_strlen(S::value())>(S::value(), std::make_index_sequence<static_strlen(S::value())>());
+}
+
+template <size_t N1, size_t N2, size_t... I1, size_t... I2>
+constexpr static_string<N1 + N2> concat(const static_string<N1> &a, const static_string<N2> &b, std::index_sequence<I1...>, std::index_sequence<I2...>) {
+    return { { a.data[I1]..., b.data[I2]..., '\0' } };
+}
+
+template <size_t N1, size_t N2>
+constexpr static_string<N1 + N2> operator+(const static_string<N1> &a, const static_string<N2> &b) {
+    return concat(a, b, std::make_index_sequence<N1>(), std::make_index_sequence<N2>());
+}
+
+template <size_t V, bool = (V < 10)>
+struct decimal_string;
+
+template <size_t V>
+struct decimal_string<V, true> {
+    static constexpr static_string<1> value() { return { { char('0' + V), '\0' } }; }
+};
+
+template <size_t V>
+struct decimal_string<V, false> {
+    static constexpr auto value() { return decimal_string<V / 10>::value() + decimal_string<V % 10>::value(); }
+};
+
+template <typename T>
+struct glsl_type_name {
+    static constexpr const char *value() { return GLTypeTraits<T>::glsl_type(); }
+};
+
+// 'f', 'd', 'i', 'u' or 'b': the scalar family the shader sees for T.
+template <typename T>
+constexpr char glsl_family() {
+    return GLTypeTraits<T>::glsl_type()[0] == 'd' ? 'd'
+        : GLTypeTraits<T>::glsl_type()[0] == 'i' ? 'i'
+        : GLTypeTraits<T>::glsl_type()[0] == 'u' ? 'u'
+        : GLTypeTraits<T>::glsl_type()[0] == 'b' ? 'b'
+        : 'f';
+}
+
+// Sampler declared for a texture whose texels read as T.
+template <typename T>
+constexpr const char *glsl_sampler_type() {
+    return glsl_family<T>() == 'i' ? "isampler2D" : glsl_family<T>() == 'u' ? "usampler2D" : "sampler2D";
+}
+
+template <typename T, typename = void>
+struct has_color_enum : std::false_type {};
+
+template <typename T>
+struct has_color_enum<T, decltype(void(GLTypeTraits<T>::color_enum()))> : std::true_type {};
+
+template <typename T, typename Name>
+constexpr auto declaration() {
+    return make_static_string<glsl_type_name<T>>() + make_static_string(" ") + make_static_string<Name>() + make_static_string(";\n");
+}
+
+template <bool Flat>
+struct interpolation_qualifier {
+    static constexpr static_string<0> value() { return { { '\0' } }; }
+};
+
+template <>
+struct interpolation_qualifier<true> {
+    static constexpr static_string<5> value() { return make_static_string("flat "); }
+};
+
+template <size_t Location>
+constexpr auto location_layout() {
+    return make_static_string("layout(location = ") + decimal_string<Location>::value() + make_static_string(") ");
+}
+
+constexpr static_string<0> empty_declaration() {
+    return { { '\0' } };
+}
+
+// Each declaration generates its lines for both stages. Output is the index
+// of the first color attachment it would own.
+template <typename T, typename Name>
+struct vshader_uniform {
+    static const size_t n_outputs = 0;
+    template <size_t Output>
+    static constexpr auto vshader() { return make_static_string("uniform ") + declaration<T, Name>(); }
+    template <size_t Output>
+    static constexpr auto fshader() { return empty_declaration(); }
+    template <size_t Input, typename A>
+    static constexpr bool accepts_attribute() { return false; }
+    template <typename F>
+    static void for_each_output(size_t, F) {}
+};
+
+template <typename T, typename Name>
+struct fshader_uniform {
+    static const size_t n_outputs = 0;
+    template <size_t Output>
+    static constexpr auto vshader() { return empty_declaration(); }
+    template <size_t Output>
+    static constexpr auto fshader() { return make_static_string("uniform ") + declaration<T, Name>(); }
+    template <size_t Input, typename A>
+    static constexpr bool accepts_attribute() { return false; }
+    template <typename F>
+    static void for_each_output(size_t, F) {}
+};
+
+template <size_t Location, typename T, typename Name>
+struct vshader_input {
+    static_assert(glsl_family<T>() != 'b', "GLSL does not allow boolean vertex inputs");
+
+    static const size_t n_outputs = 0;
+    template <size_t Output>
+    static constexpr auto vshader() { return location_layout<Location>() + make_static_string("in ") + declaration<T, Name>(); }
+    template <size_t Output>
+    static constexpr auto fshader() { return empty_declaration(); }
+    template <size_t Input, typename A>
+    static constexpr bool accepts_attribute() { return Input == Location && glsl_family<A>() == glsl_family<T>(); }
+    template <typename F>
+    static void for_each_output(size_t, F) {}
+};
+
+template <typename T, typename Name>
+struct vfshader_interface {
+    static const size_t n_outputs = 0;
+    template <size_t Output>
+    static constexpr auto vshader() { return interpolation_qualifier<glsl_family<T>() != 'f' && glsl_family<T>() != 'd'>::value() + make_static_string("out ") + declaration<T, Name>(); }
+    template <size_t Output>
+    static constexpr auto fshader() { return interpolation_qualifier<glsl_family<T>() != 'f' && glsl_family<T>() != 'd'>::value() + make_static_string("in ") + declaration<T, Name>(); }
+    template <size_t Input, typename A>
+    static constexpr bool accepts_attribute() { return false; }
+    template <typename F>
+    static void for_each_output(size_t, F) {}
+};
+
+// Fragment outputs take consecutive locations in declaration order; the color
+// attachment format is derived from T, so both sides always agree.
+template <typename T, typename Name>
+struct fshader_output {
+    static_assert(has_color_enum<T>::value, "fragment output type has no color-renderable format");
+
+    static const size_t n_outputs = 1;
+    template <size_t Output>
+    static constexpr auto vshader() { return empty_declaration(); }
+    template <size_t Output>
+    static constexpr auto fshader() { return location_layout<Output>() + make_static_string("out ") + declaration<T, Name>(); }
+    template <size_t Input, typename A>
+    static constexpr bool accepts_attribute() { return false; }
+    template <typename F>
+    static void for_each_output(size_t location, F f) { f(location, Name::value(), GLTypeTraits<T>::color_enum()); }
+};
+
+template <size_t Output, typename... Declarations>
+struct layout_builder;
+
+template <size_t Output>
+struct layout_builder<Output> {
+    static const size_t n_outputs = 0;
+    static constexpr auto vshader() { return empty_declaration(); }
+    static constexpr auto fshader() { return empty_declaration(); }
+    template <size_t Input, typename A>
+    static constexpr bool accepts_attribute() { return false; }
+    template <typename F>
+    static void for_each_output(F) {}
+};
+
+template <size_t Output, typename D, typename... Rest>
+struct layout_builder<Output, D, Rest...> {
+    typedef layout_builder<Output + D::n_outputs, Rest...> next;
+    static const size_t n_outputs = D::n_outputs + next::n_outputs;
+    static constexpr auto vshader() { return D::template vshader<Output>() + next::vshader(); }
+    static constexpr auto fshader() { return D::template fshader<Output>() + next::fshader(); }
+    template <size_t Input, typename A>
+    static constexpr bool accepts_attribute() { return D::template accepts_attribute<Input, A>() || next::template accepts_attribute<Input, A>(); }
+    template <typename F>
+    static void for_each_output(F f) {
+        D::for_each_output(Output, f);
+        next::for_each_output(f);
+    }
+};
+
+template <typename... Declarations>
+struct ShaderLayout {
+    typedef layout_builder<0, Declarations...> builder;
+
+    static const size_t n_outputs = builder::n_outputs;
+
+    static constexpr auto vshader_declarations() { return builder::vshader(); }
+    static constexpr auto fshader_declarations() { return builder::fshader(); }
+
+    // True if an attribute of type A can feed the vertex input at location Input.
+    template <size_t Input, typename A>
+    static constexpr bool accepts_attribute() { return builder::template accepts_attribute<Input, A>(); }
+
+    // Calls f(location, name, color format) for every fragment output.
+    template <typename F>
+    static void for_each_output(F f) { builder::for_each_output(f); }
+};
@@ -1,8 +1,13 @@
+#pragma once
+
 #include <string>
 
 #include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
 #include <glbinding/gl/gl.h>
 
+#include "GLPackedTypes.h"
+
 template <gl::GLenum T>
 struct opengl_type;
 
@@ -86,6 +91,131 @@ struct opengl_type<gl::GL_RGBA32F> {
     typedef glm::vec4 type;
 };
 
+template <>
+struct opengl_type<gl::GL_R8> {
+    typedef normalized<std::uint8_t> type;
+};
+
+template <>
+struct opengl_type<gl::GL_RG8> {
+    typedef normalized<glm::u8vec2> type;
+};
+
+template <>
+struct opengl_type<gl::GL_RGBA8> {
+    typedef normalized<glm::u8vec4> type;
+};
+
+template <>
+struct opengl_type<gl::GL_R8_SNORM> {
+    typedef normalized<std::int8_t> type;
+};
+
+template <>
+struct opengl_type<gl::GL_RG8_SNORM> {
+    typedef normalized<glm::i8vec2> type;
+};
+
+template <>
+struct opengl_type<gl::GL_RGBA8_SNORM> {
+    typedef normalized<glm::i8vec4> type;
+};
+
+template <>
+struct opengl_type<gl::GL_R16> {
+    typedef normalized<std::uint16_t> type;
+};
+
+template <>
+struct opengl_type<gl::GL_RG16> {
+    typedef normalized<glm::u16vec2> type;
+};
+
+template <>
+struct opengl_type<gl::GL_RGBA16> {
+    typedef normalized<glm::u16vec4> type;
+};
+
+template <>
+struct opengl_type<gl::GL_R16_SNORM> {
+    typedef normalized<std::int16_t> type;
+};
+
+template <>
+struct opengl_type<gl::GL_RG16_SNORM> {
+    typedef normalized<glm::i16vec2> type;
+};
+
+template <>
+struct opengl_type<gl::GL_RGBA16_SNORM> {
+    typedef normalized<glm::i16vec4> type;
+};
+
+template <>
+struct opengl_type<gl::GL_R16F> {
+    typedef half type;
+};
+
+template <>
+struct opengl_type<gl::GL_RG16F> {
+    typedef hvec2 type;
+};
+
+template <>
+struct opengl_type<gl::GL_RGBA16F> {
+    typedef hvec4 type;
+};
+
+template <>
+struct opengl_type<gl::GL_R11F_G11F_B10F> {
+    typedef uint_10f_11f_11f_rev type;
+};
+
+template <>
+struct opengl_type<gl::GL_RGB10_A2> {
+    typedef normalized<uint_2_10_10_10_rev> type;
+};
+
+template <>
+struct opengl_type<gl::GL_RG8I> {
+    typedef glm::i8vec2 type;
+};
+
+template <>
+struct opengl_type<gl::GL_RG8UI> {
+    typedef glm::u8vec2 type;
+};
+
+template <>
+struct opengl_type<gl::GL_RGBA8I> {
+    typedef glm::i8vec4 type;
+};
+
+template <>
+struct opengl_type<gl::GL_RGBA8UI> {
+    typedef glm::u8vec4 type;
+};
+
+template <>
+struct opengl_type<gl::GL_RG16I> {
+    typedef glm::i16vec2 type;
+};
+
+template <>
+struct opengl_type<gl::GL_RG16UI> {
+    typedef glm::u16vec2 type;
+};
+
+template <>
+struct opengl_type<gl::GL_RGBA16I> {
+    typedef glm::i16vec4 type;
+};
+
+template <>
+struct opengl_type<gl::GL_RGBA16UI> {
+    typedef glm::u16vec4 type;
+};
+
 template <typename T>
 struct GLTypeTraits;
 
@@ -94,47 +224,63 @@ struct GLTypeTraits<bool> {
     typedef bool element_type;
     static const size_t dimension = 1;
     static const gl::GLenum opengl_enum = gl::GL_BOOL;
-    static std::string glsl_type() { return "bool"; }
+    static constexpr const char *glsl_type() { return "bool"; }
 };
 
 template <>
 struct GLTypeTraits<std::int8_t> {
     typedef std::int8_t element_type;
     static const size_t dimension = 1;
+    static const gl::GLenum opengl_enum = gl::GL_BYTE;
     typedef GLTypeTraits<std::int8_t> signed_type;
     typedef GLTypeTraits<std::uint8_t> unsigned_type;
-    static gl::GLenum color_enum() { return gl::GL_R8I; }
-    static std::string image_format() { return "r8i"; }
+    static constexpr gl::GLenum color_enum() { return gl::GL_R8I; }
+    static constexpr const char *glsl_type() { return "int"; }
+    static constexpr const char *image_format() { return "r8i"; }
+    static constexpr gl::GLenum normalized_color_enum() { return gl::GL_R8_SNORM; }
+    static constexpr const char *normalized_image_format() { return "r8_snorm"; }
 };
 
 template <>
 struct GLTypeTraits<std::uint8_t> {
     typedef std::uint8_t element_type;
     static const size_t dimension = 1;
+    static const gl::GLenum opengl_enum = gl::GL_UNSIGNED_BYTE;
     typedef GLTypeTraits<std::int8_t> signed_type;
     typedef GLTypeTraits<std::uint8_t> unsigned_type;
-    static gl::GLenum color_enum() { return gl::GL_R8UI; }
-    static std::string image_format() { return "r8ui"; }
+    static constexpr gl::GLenum color_enum() { return gl::GL_R8UI; }
+    static constexpr const char *glsl_type() { return "uint"; }
+    static constexpr const char *image_format() { return "r8ui"; }
+    static constexpr gl::GLenum normalized_color_enum() { return gl::GL_R8; }
+    static constexpr const char *normalized_image_format() { return "r8"; }
 };
 
 template <>
 struct GLTypeTraits<std::int16_t> {
     typedef std::int16_t element_type;
     static const size_t dimension = 1;
+    static const gl::GLenum opengl_enum = gl::GL_SHORT;
     typedef GLTypeTraits<std::int16_t> signed_type;
     typedef GLTypeTraits<std::uint16_t> unsigned_type;
-    static gl::GLenum color_enum() { return gl::GL_R16I; }
-    static std::string image_format() { return "r16i"; }
+    static constexpr gl::GLenum color_enum() { return gl::GL_R16I; }
+    static constexpr const char *glsl_type() { return "int"; }
+    static constexpr const char *image_format() { return "r16i"; }
+    static constexpr gl::GLenum normalized_color_enum() { return gl::GL_R16_SNORM; }
+    static constexpr const char *normalized_image_format() { return "r16_snorm"; }
 };
 
 template <>
 struct GLTypeTraits<std::uint16_t> {
     typedef std::uint16_t element_type;
     static const size_t dimension = 1;
+    static const gl::GLenum opengl_enum = gl::GL_UNSIGNED_SHORT;
     typedef GLTypeTraits<std::int16_t> signed_type;
     typedef GLTypeTraits<std::uint16_t> unsigned_type;
-    static gl::GLenum color_enum() { return gl::GL_R16UI; }
-    static std::string image_format() { return "r16ui"; }
+    static constexpr gl::GLenum color_enum() { return gl::GL_R16UI; }
+    static constexpr const char *glsl_type() { return "uint"; }
+    static constexpr const char *image_format() { return "r16ui"; }
+    static constexpr gl::GLenum normalized_color_enum() { return gl::GL_R16; }
+    static constexpr const char *normalized_image_format() { return "r16"; }
 };
 
 template <>
@@ -144,9 +290,9 @@ struct GLTypeTraits<std::int32_t> {
     static const gl::GLenum opengl_enum = gl::GL_INT;
     typedef GLTypeTraits<std::int32_t> signed_type;
     typedef GLTypeTraits<std::uint32_t> unsigned_type;
-    static gl::GLenum color_enum() { return gl::GL_R32I; }
-    static std::string glsl_type() { return "int"; }
-    static std::string image_format() { return "r32i"; }
+    static constexpr gl::GLenum color_enum() { return gl::GL_R32I; }
+    static constexpr const char *glsl_type() { return "int"; }
+    static constexpr const char *image_format() { return "r32i"; }
 };
 
 template <>
@@ -156,9 +302,9 @@ struct GLTypeTraits<std::uint32_t> {
     static const gl::GLenum opengl_enum = gl::GL_UNSIGNED_INT;
     typedef GLTypeTraits<std::int32_t> signed_type;
     typedef GLTypeTraits<std::uint32_t> unsigned_type;
-    static gl::GLenum color_enum() { return gl::GL_R32UI; }
-    static std::string glsl_type() { return "uint"; }
-    static std::string image_format() { return "r32ui"; }
+    static constexpr gl::GLenum color_enum() { return gl::GL_R32UI; }
+    static constexpr const char *glsl_type() { return "uint"; }
+    static constexpr const char *image_format() { return "r32ui"; }
 };
 
 template <>
@@ -166,9 +312,9 @@ struct GLTypeTraits<float> {
     typedef float element_type;
     static const size_t dimension = 1;
     static const gl::GLenum opengl_enum = gl::GL_FLOAT;
-    static gl::GLenum color_enum() { return gl::GL_R32F; }
-    static std::string glsl_type() { return "float"; }
-    static std::string image_format() { return "r32f"; }
+    static constexpr gl::GLenum color_enum() { return gl::GL_R32F; }
+    static constexpr const char *glsl_type() { return "float"; }
+    static constexpr const char *image_format() { return "r32f"; }
 };
 
 template <>
@@ -176,14 +322,14 @@ struct GLTypeTraits<double> {
     typedef double element_type;
     static const size_t dimension = 1;
     static const gl::GLenum opengl_enum = gl::GL_DOUBLE;
-    static std::string glsl_type() { return "double"; }
+    static constexpr const char *glsl_type() { return "double"; }
 };
 
 template <>
 struct GLTypeTraits<glm::bvec2> {
     typedef bool element_type;
     static const size_t dimension = 2;
-    static std::string glsl_type() { return "bvec2"; }
+    static constexpr const char *glsl_type() { return "bvec2"; }
 };
 
 template <>
@@ -192,9 +338,9 @@ struct GLTypeTraits<glm::ivec2> {
     static const size_t dimension = 2;
     typedef GLTypeTraits<glm::ivec2> signed_type;
     typedef GLTypeTraits<glm::uvec2> unsigned_type;
-    static gl::GLenum color_enum() { return gl::GL_RG32I; }
-    static std::string glsl_type() { return "ivec2"; }
-    static std::string image_format() { return "rg32i"; }
+    static constexpr gl::GLenum color_enum() { return gl::GL_RG32I; }
+    static constexpr const char *glsl_type() { return "ivec2"; }
+    static constexpr const char *image_format() { return "rg32i"; }
 };
 
 template <>
@@ -203,32 +349,32 @@ struct GLTypeTraits<glm::uvec2> {
     static const size_t dimension = 2;
     typedef GLTypeTraits<glm::ivec2> signed_type;
     typedef GLTypeTraits<glm::uvec2> unsigned_type;
-    static gl::GLenum color_enum() { return gl::GL_RG32UI; }
-    static std::string glsl_type() { return "uvec2"; }
-    static std::string image_format() { return "rg32ui"; }
+    static constexpr gl::GLenum color_enum() { return gl::GL_RG32UI; }
+    static constexpr const char *glsl_type() { return "uvec2"; }
+    static constexpr const char *image_format() { return "rg32ui"; }
 };
 
 template <>
 struct GLTypeTraits<glm::vec2> {
     typedef float element_type;
     static const size_t dimension = 2;
-    static gl::GLenum color_enum() { return gl::GL_RG32F; }
-    static std::string glsl_type() { return "vec2"; }
-    static std::string image_format() { return "rg32f"; }
+    static constexpr gl::GLenum color_enum() { return gl::GL_RG32F; }
+    static constexpr const char *glsl_type() { return "vec2"; }
+    static constexpr const char *image_format() { return "rg32f"; }
 };
 
 template <>
 struct GLTypeTraits<glm::dvec2> {
     typedef double element_type;
     static const size_t dimension = 2;
-    static std::string glsl_type() { return "dvec2"; }
+    static constexpr const char *glsl_type() { return "dvec2"; }
 };
 
 template <>
 struct GLTypeTraits<glm::bvec3> {
     typedef bool element_type;
     static const size_t dimension = 3;
-    static std::string glsl_type() { return "bvec3"; }
+    static constexpr const char *glsl_type() { return "bvec3"; }
 };
 
 template <>
@@ -237,8 +383,8 @@ struct GLTypeTraits<glm::ivec3> {
     static const size_t dimension = 3;
     typedef GLTypeTraits<glm::ivec3> signed_type;
     typedef GLTypeTraits<glm::uvec3> unsigned_type;
-    static gl::GLenum color_enum() { return gl::GL_RGB32I; }
-    static std::string glsl_type() { return "ivec3"; }
+    static constexpr gl::GLenum color_enum() { return gl::GL_RGB32I; }
+    static constexpr const char *glsl_type() { return "ivec3"; }
 };
 
 template <>
@@ -247,30 +393,30 @@ struct GLTypeTraits<glm::uvec3> {
     static const size_t dimension = 3;
     typedef GLTypeTraits<glm::ivec3> signed_type;
     typedef GLTypeTraits<glm::uvec3> unsigned_type;
-    static gl::GLenum color_enum() { return gl::GL_RGB32UI; }
-    static std::string glsl_type() { return "uvec3"; }
+    static constexpr gl::GLenum color_enum() { return gl::GL_RGB32UI; }
+    static constexpr const char *glsl_type() { return "uvec3"; }
 };
 
 template <>
 struct GLTypeTraits<glm::vec3> {
     typedef float element_type;
     static const size_t dimension = 3;
-    static gl::GLenum color_enum() { return gl::GL_RGB32F; }
-    static std::string glsl_type() { return "vec3"; }
+    static constexpr gl::GLenum color_enum() { return gl::GL_RGB32F; }
+    static constexpr const char *glsl_type() { return "vec3"; }
 };
 
 template <>
 struct GLTypeTraits<glm::dvec3> {
     typedef double element_type;
     static const size_t dimension = 3;
-    static std::string glsl_type() { return "dvec3"; }
+    static constexpr const char *glsl_type() { return "dvec3"; }
 };
 
 template <>
 struct GLTypeTraits<glm::bvec4> {
     typedef bool element_type;
     static const size_t dimension = 4;
-    static std::string glsl_type() { return "bvec4"; }
+    static constexpr const char *glsl_type() { return "bvec4"; }
 };
 
 template <>
@@ -279,9 +425,9 @@ struct GLTypeTraits<glm::ivec4> {
     static const size_t dimension = 4;
     typedef GLTypeTraits<glm::ivec4> signed_type;
     typedef GLTypeTraits<glm::uvec4> unsigned_type;
-    static gl::GLenum color_enum() { return gl::GL_RGBA32I; }
-    static std::string glsl_type() { return "ivec4"; }
-    static std::string image_format() { return "rgba32i"; }
+    static constexpr gl::GLenum color_enum() { return gl::GL_RGBA32I; }
+    static constexpr const char *glsl_type() { return "ivec4"; }
+    static constexpr const char *image_format() { return "rgba32i"; }
 };
 
 template <>
@@ -290,154 +436,389 @@ struct GLTypeTraits<glm::uvec4> {
     static const size_t dimension = 4;
     typedef GLTypeTraits<glm::ivec4> signed_type;
     typedef GLTypeTraits<glm::uvec4> unsigned_type;
-    static gl::GLenum color_enum() { return gl::GL_RGBA32UI; }
-    static std::string glsl_type() { return "uvec4"; }
-    static std::string image_format() { return "rgba32ui"; }
+    static constexpr gl::GLenum color_enum() { return gl::GL_RGBA32UI; }
+    static constexpr const char *glsl_type() { return "uvec4"; }
+    static constexpr const char *image_format() { return "rgba32ui"; }
 };
 
 template <>
 struct GLTypeTraits<glm::vec4> {
     typedef float element_type;
     static const size_t dimension = 4;
-    static gl::GLenum color_enum() { return gl::GL_RGBA32F; }
-    static std::string glsl_type() { return "vec4"; }
-    static std::string image_format() { return "rgba32f"; }
+    static constexpr gl::GLenum color_enum() { return gl::GL_RGBA32F; }
+    static constexpr const char *glsl_type() { return "vec4"; }
+    static constexpr const char *image_format() { return "rgba32f"; }
 };
 
 template <>
 struct GLTypeTraits<glm::dvec4> {
     typedef double element_type;
     static const size_t dimension = 4;
-    static std::string glsl_type() { return "dvec4"; }
+    static constexpr const char *glsl_type() { return "dvec4"; }
 };
 
 template <>
 struct GLTypeTraits<glm::mat2> {
     typedef float element_type;
     static const size_t dimension = 4;
-    static std::string glsl_type() { return "mat2"; }
+    static constexpr const char *glsl_type() { return "mat2"; }
 };
 
 template <>
 struct GLTypeTraits<glm::mat2x3> {
     typedef float element_type;
     static const size_t dimension = 6;
-    static std::string glsl_type() { return "mat2x3"; }
+    static constexpr const char *glsl_type() { return "mat2x3"; }
 };
 
 template <>
 struct GLTypeTraits<glm::mat2x4> {
     typedef float element_type;
     static const size_t dimension = 8;
-    static std::string glsl_type() { return "mat2x4"; }
+    static constexpr const char *glsl_type() { return "mat2x4"; }
 };
 
 template <>
 struct GLTypeTraits<glm::mat3x2> {
     typedef float element_type;
     static const size_t dimension = 6;
-    static std::string glsl_type() { return "mat3x2"; }
+    static constexpr const char *glsl_type() { return "mat3x2"; }
 };
 
 template <>
 struct GLTypeTraits<glm::mat3> {
     typedef float element_type;
     static const size_t dimension = 9;
-    static std::string glsl_type() { return "mat3"; }
+    static constexpr const char *glsl_type() { return "mat3"; }
 };
 
 template <>
 struct GLTypeTraits<glm::mat3x4> {
     typedef float element_type;
     static const size_t dimension = 12;
-    static std::string glsl_type() { return "mat3x4"; }
+    static constexpr const char *glsl_type() { return "mat3x4"; }
 };
 
 template <>
 struct GLTypeTraits<glm::mat4x2> {
     typedef float element_type;
     static const size_t dimension = 8;
-    static std::string glsl_type() { return "mat4x2"; }
+    static constexpr const char *glsl_type() { return "mat4x2"; }
 };
 
 template <>
 struct GLTypeTraits<glm::mat4x3> {
     typedef float element_type;
     static const size_t dimension = 12;
-    static std::string glsl_type() { return "mat4x3"; }
+    static constexpr const char *glsl_type() { return "mat4x3"; }
 };
 
 template <>
 struct GLTypeTraits<glm::mat4> {
     typedef float element_type;
     static const size_t dimension = 16;
-    static std::string glsl_type() { return "mat4"; }
+    static constexpr const char *glsl_type() { return "mat4"; }
 };
 
 template <>
 struct GLTypeTraits<glm::dmat2> {
     typedef double element_type;
     static const size_t dimension = 4;
-    static std::string glsl_type() { return "dmat2"; }
+    static constexpr const char *glsl_type() { return "dmat2"; }
 };
 
 template <>
 struct GLTypeTraits<glm::dmat2x3> {
     typedef double element_type;
     static const size_t dimension = 6;
-    static std::string glsl_type() { return "dmat2x3"; }
+    static constexpr const char *glsl_type() { return "dmat2x3"; }
 };
 
 template <>
 struct GLTypeTraits<glm::dmat2x4> {
     typedef double element_type;
     static const size_t dimension = 8;
-    static std::string glsl_type() { return "dmat2x4"; }
+    static constexpr const char *glsl_type() { return "dmat2x4"; }
 };
 
 template <>
 struct GLTypeTraits<glm::dmat3x2> {
     typedef double element_type;
     static const size_t dimension = 6;
-    static std::string glsl_type() { return "dmat3x2"; }
+    static constexpr const char *glsl_type() { return "dmat3x2"; }
 };
 
 template <>
 struct GLTypeTraits<glm::dmat3> {
     typedef double element_type;
     static const size_t dimension = 9;
-    static std::string glsl_type() { return "dmat3"; }
+    static constexpr const char *glsl_type() { return "dmat3"; }
 };
 
 template <>
 struct GLTypeTraits<glm::dmat3x4> {
     typedef double element_type;
     static const size_t dimension = 12;
-    static std::string glsl_type() { return "dmat3x4"; }
+    static constexpr const char *glsl_type() { return "dmat3x4"; }
 };
 
 template <>
 struct GLTypeTraits<glm::dmat4x2> {
     typedef double element_type;
     static const size_t dimension = 8;
-    static std::string glsl_type() { return "dmat4x2"; }
+    static constexpr const char *glsl_type() { return "dmat4x2"; }
 };
 
 template <>
 struct GLTypeTraits<glm::dmat4x3> {
     typedef double element_type;
     static const size_t dimension = 12;
-    static std::string glsl_type() { return "dmat4x3"; }
+    static constexpr const char *glsl_type() { return "dmat4x3"; }
 };
 
 template <>
 struct GLTypeTraits<glm::dmat4> {
     typedef double element_type;
     static const size_t dimension = 16;
-    static std::string glsl_type() { return "dmat4"; }
+    static constexpr const char *glsl_type() { return "dmat4"; }
+};
+
+template <>
+struct GLTypeTraits<glm::i8vec2> {
+    typedef std::int8_t element_type;
+    static const size_t dimension = 2;
+    typedef GLTypeTraits<glm::i8vec2> signed_type;
+    typedef GLTypeTraits<glm::u8vec2> unsigned_type;
+    static constexpr gl::GLenum color_enum() { return gl::GL_RG8I; }
+    static constexpr const char *glsl_type() { return "ivec2"; }
+    static constexpr const char *image_format() { return "rg8i"; }
+    static constexpr gl::GLenum normalized_color_enum() { return gl::GL_RG8_SNORM; }
+    static constexpr const char *normalized_image_format() { return "rg8_snorm"; }
+};
+
+template <>
+struct GLTypeTraits<glm::u8vec2> {
+    typedef std::uint8_t element_type;
+    static const size_t dimension = 2;
+    typedef GLTypeTraits<glm::i8vec2> signed_type;
+    typedef GLTypeTraits<glm::u8vec2> unsigned_type;
+    static constexpr gl::GLenum color_enum() { return gl::GL_RG8UI; }
+    static constexpr const char *glsl_type() { return "uvec2"; }
+    static constexpr const char *image_format() { return "rg8ui"; }
+    static constexpr gl::GLenum normalized_color_enum() { return gl::GL_RG8; }
+    static constexpr const char *normalized_image_format() { return "rg8"; }
+};
+
+template <>
+struct GLTypeTraits<glm::i16vec2> {
+    typedef std::int16_t element_type;
+    static const size_t dimension = 2;
+    typedef GLTypeTraits<glm::i16vec2> signed_type;
+    typedef GLTypeTraits<glm::u16vec2> unsigned_type;
+    static constexpr gl::GLenum color_enum() { return gl::GL_RG16I; }
+    static constexpr const char *glsl_type() { return "ivec2"; }
+    static constexpr const char *image_format() { return "rg16i"; }
+    static constexpr gl::GLenum normalized_color_enum() { return gl::GL_RG16_SNORM; }
+    static constexpr const char *normalized_image_format() { return "rg16_snorm"; }
+};
+
+template <>
+struct GLTypeTraits<glm::u16vec2> {
+    typedef std::uint16_t element_type;
+    static const size_t dimension = 2;
+    typedef GLTypeTraits<glm::i16vec2> signed_type;
+    typedef GLTypeTraits<glm::u16vec2> unsigned_type;
+    static constexpr gl::GLenum color_enum() { return gl::GL_RG16UI; }
+    static constexpr const char *glsl_type() { return "uvec2"; }
+    static constexpr const char *image_format() { return "rg16ui"; }
+    static constexpr gl::GLenum normalized_color_enum() { return gl::GL_RG16; }
+    static constexpr const char *normalized_image_format() { return "rg16"; }
+};
+
+template <>
+struct GLTypeTraits<glm::i8vec3> {
+    typedef std::int8_t element_type;
+    static const size_t dimension = 3;
+    typedef GLTypeTraits<glm::i8vec3> signed_type;
+    typedef GLTypeTraits<glm::u8vec3> unsigned_type;
+    static constexpr const char *glsl_type() { return "ivec3"; }
 };
 
-inline std::string glsl_type(gl::GLenum type) {
+template <>
+struct GLTypeTraits<glm::u8vec3> {
+    typedef std::uint8_t element_type;
+    static const size_t dimension = 3;
+    typedef GLTypeTraits<glm::i8vec3> signed_type;
+    typedef GLTypeTraits<glm::u8vec3> unsigned_type;
+    static constexpr const char *glsl_type() { return "uvec3"; }
+};
+
+template <>
+struct GLTypeTraits<glm::i16vec3> {
+    typedef std::int16_t element_type;
+    static const size_t dimension = 3;
+    typedef GLTypeTraits<glm::i16vec3> signed_type;
+    typedef GLTypeTraits<glm::u16vec3> unsigned_type;
+    static constexpr const char *glsl_type() { return "ivec3"; }
+};
+
+template <>
+struct GLTypeTraits<glm::u16vec3> {
+    typedef std::uint16_t element_type;
+    static const size_t dimension = 3;
+    typedef GLTypeTraits<glm::i16vec3> signed_type;
+    typedef GLTypeTraits<glm::u16vec3> unsigned_type;
+    static constexpr const char *glsl_type() { return "uvec3"; }
+};
+
+template <>
+struct GLTypeTraits<glm::i8vec4> {
+    typedef std::int8_t element_type;
+    static const size_t dimension = 4;
+    typedef GLTypeTraits<glm::i8vec4> signed_type;
+    typedef GLTypeTraits<glm::u8vec4> unsigned_type;
+    static constexpr gl::GLenum color_enum() { return gl::GL_RGBA8I; }
+    static constexpr const char *glsl_type() { return "ivec4"; }
+    static constexpr const char *image_format() { return "rgba8i"; }
+    static constexpr gl::GLenum normalized_color_enum() { return gl::GL_RGBA8_SNORM; }
+    static constexpr const char *normalized_image_format() { return "rgba8_snorm"; }
+};
+
+template <>
+struct GLTypeTraits<glm::u8vec4> {
+    typedef std::uint8_t element_type;
+    static const size_t dimension = 4;
+    typedef GLTypeTraits<glm::i8vec4> signed_type;
+    typedef GLTypeTraits<glm::u8vec4> unsigned_type;
+    static constexpr gl::GLenum color_enum() { return gl::GL_RGBA8UI; }
+    static constexpr const char *glsl_type() { return "uvec4"; }
+    static constexpr const char *image_format() { return "rgba8ui"; }
+    static constexpr gl::GLenum normalized_color_enum() { return gl::GL_RGBA8; }
+    static constexpr const char *normalized_image_format() { return "rgba8"; }
+};
+
+template <>
+struct GLTypeTraits<glm::i16vec4> {
+    typedef std::int16_t element_type;
+    static const size_t dimension = 4;
+    typedef GLTypeTraits<glm::i16vec4> signed_type;
+    typedef GLTypeTraits<glm::u16vec4> unsigned_type;
+    static constexpr gl::GLenum color_enum() { return gl::GL_RGBA16I; }
+    static constexpr const char *glsl_type() { return "ivec4"; }
+    static constexpr const char *image_format() { return "rgba16i"; }
+    static constexpr gl::GLenum normalized_color_enum() { return gl::GL_RGBA16_SNORM; }
+    static constexpr const char *normalized_image_format() { return "rgba16_snorm"; }
+};
+
+template <>
+struct GLTypeTraits<glm::u16vec4> {
+    typedef std::uint16_t element_type;
+    static const size_t dimension = 4;
+    typedef GLTypeTraits<glm::i16vec4> signed_type;
+    typedef GLTypeTraits<glm::u16vec4> unsigned_type;
+    static constexpr gl::GLenum color_enum() { return gl::GL_RGBA16UI; }
+    static constexpr const char *glsl_type() { return "uvec4"; }
+    static constexpr const char *image_format() { return "rgba16ui"; }
+    static constexpr gl::GLenum normalized_color_enum() { return gl::GL_RGBA16; }
+    static constexpr const char *normalized_image_format() { return "rgba16"; }
+};
+
+template <>
+struct GLTypeTraits<half> {
+    typedef half element_type;
+    static const size_t dimension = 1;
+    static const gl::GLenum opengl_enum = gl::GL_HALF_FLOAT;
+    static constexpr const char *glsl_type() { return "float"; }
+    static constexpr gl::GLenum color_enum() { return gl::GL_R16F; }
+    static constexpr const char *image_format() { return "r16f"; }
+};
+
+template <>
+struct GLTypeTraits<hvec2> {
+    typedef half element_type;
+    static const size_t dimension = 2;
+    static constexpr const char *glsl_type() { return "vec2"; }
+    static constexpr gl::GLenum color_enum() { return gl::GL_RG16F; }
+    static constexpr const char *image_format() { return "rg16f"; }
+};
+
+template <>
+struct GLTypeTraits<hvec3> {
+    typedef half element_type;
+    static const size_t dimension = 3;
+    static constexpr const char *glsl_type() { return "vec3"; }
+};
+
+template <>
+struct GLTypeTraits<hvec4> {
+    typedef half element_type;
+    static const size_t dimension = 4;
+    static constexpr const char *glsl_type() { return "vec4"; }
+    static constexpr gl::GLenum color_enum() { return gl::GL_RGBA16F; }
+    static constexpr const char *image_format() { return "rgba16f"; }
+};
+
+template <>
+struct GLTypeTraits<int_2_10_10_10_rev> {
+    typedef int_2_10_10_10_rev element_type;
+    static const size_t dimension = 4;
+    static const gl::GLenum opengl_enum = gl::GL_INT_2_10_10_10_REV;
+    static constexpr const char *glsl_type() { return "vec4"; }
+};
+
+template <>
+struct GLTypeTraits<uint_2_10_10_10_rev> {
+    typedef uint_2_10_10_10_rev element_type;
+    static const size_t dimension = 4;
+    static const gl::GLenum opengl_enum = gl::GL_UNSIGNED_INT_2_10_10_10_REV;
+    static constexpr const char *glsl_type() { return "vec4"; }
+    static constexpr gl::GLenum normalized_color_enum() { return gl::GL_RGB10_A2; }
+    static constexpr const char *normalized_image_format() { return "rgb10_a2"; }
+};
+
+template <>
+struct GLTypeTraits<uint_10f_11f_11f_rev> {
+    typedef uint_10f_11f_11f_rev element_type;
+    static const size_t dimension = 3;
+    static const gl::GLenum opengl_enum = gl::GL_UNSIGNED_INT_10F_11F_11F_REV;
+    static constexpr const char *glsl_type() { return "vec3"; }
+    static constexpr gl::GLenum color_enum() { return gl::GL_R11F_G11F_B10F; }
+    static constexpr const char *image_format() { return "r11f_g11f_b10f"; }
+};
+
+template <size_t N>
+struct float_vector;
+
+template <>
+struct float_vector<1> {
+    typedef float type;
+};
+
+template <>
+struct float_vector<2> {
+    typedef glm::vec2 type;
+};
+
+template <>
+struct float_vector<3> {
+    typedef glm::vec3 type;
+};
+
+template <>
+struct float_vector<4> {
+    typedef glm::vec4 type;
+};
+
+template <typename T>
+struct GLTypeTraits<normalized<T>> {
+    typedef typename GLTypeTraits<T>::element_type element_type;
+    static const size_t dimension = GLTypeTraits<T>::dimension;
+    static constexpr const char *glsl_type() { return GLTypeTraits<typename float_vector<dimension>::type>::glsl_type(); }
+    static constexpr gl::GLenum color_enum() { return GLTypeTraits<T>::normalized_color_enum(); }
+    static constexpr const char *image_format() { return GLTypeTraits<T>::normalized_image_format(); }
+};
+
+inline const char *glsl_type(gl::GLenum type) {
     switch (type) {
     case gl::GL_R32I:
         return GLTypeTraits<typename opengl_type<gl::GL_R32I>::type>::glsl_type();
@@ -463,8 +844,169 @@ inline std::string glsl_type(gl::GLenum type) {
         return GLTypeTraits<typename opengl_type<gl::GL_RGBA32UI>::type>::glsl_type();
     case gl::GL_RGBA32F:
         return GLTypeTraits<typename opengl_type<gl::GL_RGBA32F>::type>::glsl_type();
+    case gl::GL_R8I:
+        return GLTypeTraits<typename opengl_type<gl::GL_R8I>::type>::glsl_type();
+    case gl::GL_R8UI:
+        return GLTypeTraits<typename opengl_type<gl::GL_R8UI>::type>::glsl_type();
+    case gl::GL_R16I:
+        return GLTypeTraits<typename opengl_type<gl::GL_R16I>::type>::glsl_type();
+    case gl::GL_R16UI:
+        return GLTypeTraits<typename opengl_type<gl::GL_R16UI>::type>::glsl_type();
+    case gl::GL_R8:
+        return GLTypeTraits<typename opengl_type<gl::GL_R8>::type>::glsl_type();
+    case gl::GL_RG8:
+        return GLTypeTraits<typename opengl_type<gl::GL_RG8>::type>::glsl_type();
+    case gl::GL_RGBA8:
+        return GLTypeTraits<typename opengl_type<gl::GL_RGBA8>::type>::glsl_type();
+    case gl::GL_R8_SNORM:
+        return GLTypeTraits<typename opengl_type<gl::GL_R8_SNORM>::type>::glsl_type();
+    case gl::GL_RG8_SNORM:
+        return GLTypeTraits<typename opengl_type<gl::GL_RG8_SNORM>::type>::glsl_type();
+    case gl::GL_RGBA8_SNORM:
+        return GLTypeTraits<typename opengl_type<gl::GL_RGBA8_SNORM>::type>::glsl_type();
+    case gl::GL_R16:
+        return GLTypeTraits<typename opengl_type<gl::GL_R16>::type>::glsl_type();
+    case gl::GL_RG16:
+        return GLTypeTraits<typename opengl_type<gl::GL_RG16>::type>::glsl_type();
+    case gl::GL_RGBA16:
+        return GLTypeTraits<typename opengl_type<gl::GL_RGBA16>::type>::glsl_type();
+    case gl::GL_R16_SNORM:
+        return GLTypeTraits<typename opengl_type<gl::GL_R16_SNORM>::type>::glsl_type();
+    case gl::GL_RG16_SNORM:
+        return GLTypeTraits<typename opengl_type<gl::GL_RG16_SNORM>::type>::glsl_type();
+    case gl::GL_RGBA16_SNORM:
+        return GLTypeTraits<typename opengl_type<gl::GL_RGBA16_SNORM>::type>::glsl_type();
+    case gl::GL_R16F:
+        return GLTypeTraits<typename opengl_type<gl::GL_R16F>::type>::glsl_type();
+    case gl::GL_RG16F:
+        return GLTypeTraits<typename opengl_type<gl::GL_RG16F>::type>::glsl_type();
+    case gl::GL_RGBA16F:
+        return GLTypeTraits<typename opengl_type<gl::GL_RGBA16F>::type>::glsl_type();
+    case gl::GL_R11F_G11F_B10F:
+        return GLTypeTraits<typename opengl_type<gl::GL_R11F_G11F_B10F>::type>::glsl_type();
+    case gl::GL_RGB10_A2:
+        return GLTypeTraits<typename opengl_type<gl::GL_RGB10_A2>::type>::glsl_type();
+    case gl::GL_RG8I:
+        return GLTypeTraits<typename opengl_type<gl::GL_RG8I>::type>::glsl_type();
+    case gl::GL_RG8UI:
+        return GLTypeTraits<typename opengl_type<gl::GL_RG8UI>::type>::glsl_type();
+    case gl::GL_RGBA8I:
+        return GLTypeTraits<typename opengl_type<gl::GL_RGBA8I>::type>::glsl_type();
+    case gl::GL_RGBA8UI:
+        return GLTypeTraits<typename opengl_type<gl::GL_RGBA8UI>::type>::glsl_type();
+    case gl::GL_RG16I:
+        return GLTypeTraits<typename opengl_type<gl::GL_RG16I>::type>::glsl_type();
+    case gl::GL_RG16UI:
+        return GLTypeTraits<typename opengl_type<gl::GL_RG16UI>::type>::glsl_type();
+    case gl::GL_RGBA16I:
+        return GLTypeTraits<typename opengl_type<gl::GL_RGBA16I>::type>::glsl_type();
+    case gl::GL_RGBA16UI:
+        return GLTypeTraits<typename opengl_type<gl::GL_RGBA16UI>::type>::glsl_type();
     default:
         return "";
     }
 }
 
+
+struct GLPixelFormat {
+    gl::GLenum format;
+    gl::GLenum type;
+    size_t size;
+};
+
+// Client-side format/type pair which reads back an internal format without conversion.
+inline GLPixelFormat pixel_format(gl::GLenum type) {
+    switch (type) {
+    case gl::GL_R8I:
+        return { gl::GL_RED_INTEGER, gl::GL_BYTE, sizeof(opengl_type<gl::GL_R8I>::type) };
+    case gl::GL_R8UI:
+        return { gl::GL_RED_INTEGER, gl::GL_UNSIGNED_BYTE, sizeof(opengl_type<gl::GL_R8UI>::type) };
+    case gl::GL_R16I:
+        return { gl::GL_RED_INTEGER, gl::GL_SHORT, sizeof(opengl_type<gl::GL_R16I>::type) };
+    case gl::GL_R16UI:
+        return { gl::GL_RED_INTEGER, gl::GL_UNSIGNED_SHORT, sizeof(opengl_type<gl::GL_R16UI>::type) };
+    case gl::GL_R32I:
+        return { gl::GL_RED_INTEGER, gl::GL_INT, sizeof(opengl_type<gl::GL_R32I>::type) };
+    case gl::GL_R32UI:
+        return { gl::GL_RED_INTEGER, gl::GL_UNSIGNED_INT, sizeof(opengl_type<gl::GL_R32UI>::type) };
+    case gl::GL_R32F:
+        return { gl::GL_RED, gl::GL_FLOAT, sizeof(opengl_type<gl::GL_R32F>::type) };
+    case gl::GL_RG8I:
+        return { gl::GL_RG_INTEGER, gl::GL_BYTE, sizeof(opengl_type<gl::GL_RG8I>::type) };
+    case gl::GL_RG8UI:
+        return { gl::GL_RG_INTEGER, gl::GL_UNSIGNED_BYTE, sizeof(opengl_type<gl::GL_RG8UI>::type) };
+    case gl::GL_RG16I:
+        return { gl::GL_RG_INTEGER, gl::GL_SHORT, sizeof(opengl_type<gl::GL_RG16I>::type) };
+    case gl::GL_RG16UI:
+        return { gl::GL_RG_INTEGER, gl::GL_UNSIGNED_SHORT, sizeof(opengl_type<gl::GL_RG16UI>::type) };
+    case gl::GL_RG32I:
+        return { gl::GL_RG_INTEGER, gl::GL_INT, sizeof(opengl_type<gl::GL_RG32I>::type) };
+    case gl::GL_RG32UI:
+        return { gl::GL_RG_INTEGER, gl::GL_UNSIGNED_INT, sizeof(opengl_type<gl::GL_RG32UI>::type) };
+    case gl::GL_RG32F:
+        return { gl::GL_RG, gl::GL_FLOAT, sizeof(opengl_type<gl::GL_RG32F>::type) };
+    case gl::GL_RGB32I:
+        return { gl::GL_RGB_INTEGER, gl::GL_INT, sizeof(opengl_type<gl::GL_RGB32I>::type) };
+    case gl::GL_RGB32UI:
+        return { gl::GL_RGB_INTEGER, gl::GL_UNSIGNED_INT, sizeof(opengl_type<gl::GL_RGB32UI>::type) };
+    case gl::GL_RGB32F:
+        return { gl::GL_RGB, gl::GL_FLOAT, sizeof(opengl_type<gl::GL_RGB32F>::type) };
+    case gl::GL_RGBA8I:
+        return { gl::GL_RGBA_INTEGER, gl::GL_BYTE, sizeof(opengl_type<gl::GL_RGBA8I>::type) };
+    case gl::GL_RGBA8UI:
+        return { gl::GL_RGBA_INTEGER, gl::GL_UNSIGNED_BYTE, sizeof(opengl_type<gl::GL_RGBA8UI>::type) };
+    case gl::GL_RGBA16I:
+        return { gl::GL_RGBA_INTEGER, gl::GL_SHORT, sizeof(opengl_type<gl::GL_RGBA16I>::type) };
+    case gl::GL_RGBA16UI:
+        return { gl::GL_RGBA_INTEGER, gl::GL_UNSIGNED_SHORT, sizeof(opengl_type<gl::GL_RGBA16UI>::type) };
+    case gl::GL_RGBA32I:
+        return { gl::GL_RGBA_INTEGER, gl::GL_INT, sizeof(opengl_type<gl::GL_RGBA32I>::type) };
+    case gl::GL_RGBA32UI:
+        return { gl::GL_RGBA_INTEGER, gl::GL_UNSIGNED_INT, sizeof(opengl_type<gl::GL_RGBA32UI>::type) };
+    case gl::GL_RGBA32F:
+        return { gl::GL_RGBA, gl::GL_FLOAT, sizeof(opengl_type<gl::GL_RGBA32F>::type) };
+    case gl::GL_R8:
+        return { gl::GL_RED, gl::GL_UNSIGNED_BYTE, sizeof(opengl_type<gl::GL_R8>::type) };
+    case gl::GL_RG8:
+        return { gl::GL_RG, gl::GL_UNSIGNED_BYTE, sizeof(opengl_type<gl::GL_RG8>::type) };
+    case gl::GL_RGBA8:
+        return { gl::GL_RGBA, gl::GL_UNSIGNED_BYTE, sizeof(opengl_type<gl::GL_RGBA8>::type) };
+    case gl::GL_R8_SNORM:
+        return { gl::GL_RED, gl::GL_BYTE, sizeof(opengl_type<gl::GL_R8_SNORM>::type) };
+    case gl::GL_RG8_SNORM:
+        return { gl::GL_RG, gl::GL_BYTE, sizeof(opengl_type<gl::GL_RG8_SNORM>::type) };
+    case gl::GL_RGBA8_SNORM:
+        return { gl::GL_RGBA, gl::GL_BYTE, sizeof(opengl_type<gl::GL_RGBA8_SNORM>::type) };
+    case gl::GL_R16:
+        return { gl::GL_RED, gl::GL_UNSIGNED_SHORT, sizeof(opengl_type<gl::GL_R16>::type) };
+    case gl::GL_RG16:
+        return { gl::GL_RG, gl::GL_UNSIGNED_SHORT, sizeof(opengl_type<gl::GL_RG16>::type) };
+    case gl::GL_RGBA16:
+        return { gl::GL_RGBA, gl::GL_UNSIGNED_SHORT, sizeof(opengl_type<gl::GL_RGBA16>::type) };
+    case gl::GL_R16_SNORM:
+        return { gl::GL_RED, gl::GL_SHORT, sizeof(opengl_type<gl::GL_R16_SNORM>::type) };
+    case gl::GL_RG16_SNORM:
+        return { gl::GL_RG, gl::GL_SHORT, sizeof(opengl_type<gl::GL_RG16_SNORM>::type) };
+    case gl::GL_RGBA16_SNORM:
+        return { gl::GL_RGBA, gl::GL_SHORT, sizeof(opengl_type<gl::GL_RGBA16_SNORM>::type) };
+    case gl::GL_R16F:
+        return { gl::GL_RED, gl::GL_HALF_FLOAT, sizeof(opengl_type<gl::GL_R16F>::type) };
+    case gl::GL_RG16F:
+        return { gl::GL_RG, gl::GL_HALF_FLOAT, sizeof(opengl_type<gl::GL_RG16F>::type) };
+    case gl::GL_RGBA16F:
+        return { gl::GL_RGBA, gl::GL_HALF_FLOAT, sizeof(opengl_type<gl::GL_RGBA16F>::type) };
+    case gl::GL_R11F_G11F_B10F:
+        return { gl::GL_RGB, gl::GL_UNSIGNED_INT_10F_11F_11F_REV, sizeof(opengl_type<gl::GL_R11F_G11F_B10F>::type) };
+    case gl::GL_RGB10_A2:
+        return { gl::GL_RGBA, gl::GL_UNSIGNED_INT_2_10_10_10_REV, sizeof(opengl_type<gl::GL_RGB10_A2>::type) };
+    case gl::GL_DEPTH_COMPONENT16:
+        return { gl::GL_DEPTH_COMPONENT, gl::GL_UNSIGNED_SHORT, sizeof(std::uint16_t) };
+    case gl::GL_DEPTH_COMPONENT24:
+    case gl::GL_DEPTH_COMPONENT32:
+        return { gl::GL_DEPTH_COMPONENT, gl::GL_UNSIGNED_INT, sizeof(std::uint32_t) };
+    case gl::GL_DEPTH_COMPONENT32F:
+        return { gl::GL_DEPTH_COMPONENT, gl::GL_FLOAT, sizeof(float) };
+    default:
+        return { gl::GL_NONE, gl::GL_NONE, 0 };
+    }
+}
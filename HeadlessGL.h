@@ -2,27 +2,33 @@
 
 #include <Windows.h>
 
+#include <stdexcept>
+
 #pragma comment (lib, "opengl32.lib")
 
 class HeadlessGL {
 public:
     HeadlessGL() {
-        HINSTANCE hInstance = GetModuleHandle(nullptr);
-        WNDCLASS wc = { 0 };
-        wc.style = CS_OWNDC;
-        wc.lpfnWndProc = creationHandler;
-        wc.hInstance = hInstance;
-        wc.hbrBackground = (HBRUSH)(COLOR_BACKGROUND);
-        wc.lpszClassName = TEXT("Class_DummyWindowOfHeadessGL");
-        if (SUCCEEDED(RegisterClass(&wc))) {
-            m_hWnd = CreateWindow(wc.lpszClassName, TEXT("Class_DummyWindowOfHeadessGL"), 0, 0, 0, 640, 480, 0, 0, hInstance, 0);
-            m_hDC = s_hDC();
-            m_hGLRC = s_hGLRC();
+        create();
+    }
+
+    // A context sharing buffers and textures with another one, e.g. for a
+    // loader thread. Construct it on the thread owning the shared context.
+    // Throws if the contexts cannot share: nothing created here would be
+    // visible to the other context.
+    explicit HeadlessGL(const HeadlessGL *shared) {
+        create();
+        if (!wglShareLists(shared->m_hGLRC, m_hGLRC)) {
+            wglDeleteContext(m_hGLRC);
+            DestroyWindow(m_hWnd);
+            throw std::runtime_error("HeadlessGL: wglShareLists failed");
         }
     }
 
     virtual ~HeadlessGL() {
-        wglMakeCurrent(m_hDC, nullptr);
+        if (wglGetCurrentContext() == m_hGLRC) {
+            wglMakeCurrent(m_hDC, nullptr);
+        }
         wglDeleteContext(m_hGLRC);
         DestroyWindow(m_hWnd);
     }
@@ -36,6 +42,21 @@ public:
     }
 
 private:
+    void create() {
+        HINSTANCE hInstance = GetModuleHandle(nullptr);
+        WNDCLASS wc = { 0 };
+        wc.style = CS_OWNDC;
+        wc.lpfnWndProc = creationHandler;
+        wc.hInstance = hInstance;
+        wc.hbrBackground = (HBRUSH)(COLOR_BACKGROUND);
+        wc.lpszClassName = TEXT("Class_DummyWindowOfHeadessGL");
+        if (SUCCEEDED(RegisterClass(&wc))) {
+            m_hWnd = CreateWindow(wc.lpszClassName, TEXT("Class_DummyWindowOfHeadessGL"), 0, 0, 0, 640, 480, 0, 0, hInstance, 0);
+            m_hDC = s_hDC();
+            m_hGLRC = s_hGLRC();
+        }
+    }
+
     static HDC& s_hDC() {
         static HDC hDC;
         return hDC;
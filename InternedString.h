@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+#include <mutex>
+#include <unordered_set>
+
+// Returns the process-wide copy of s. Equal strings share one copy that
+// lives until exit, so descriptors can hold names as plain const char *;
+// only the first occurrence of a name allocates.
+inline const char *intern(const std::string &s) {
+    static std::mutex mutex;
+    static std::unordered_set<std::string> pool;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = pool.find(s);
+    if (found != pool.end()) {
+        return found->c_str();
+    }
+    return pool.insert(s).first->c_str();
+}
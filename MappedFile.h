@@ -0,0 +1,154 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// A whole file mapped into memory, either read-only or created read-write
+// with a fixed size.
+class MappedFile {
+public:
+    MappedFile() {
+        m_data = nullptr;
+        m_size = 0;
+#ifdef _WIN32
+        m_file = INVALID_HANDLE_VALUE;
+        m_mapping = nullptr;
+#else
+        m_fd = -1;
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile() {
+        close();
+    }
+
+    bool open(const std::string &path) {
+        close();
+#ifdef _WIN32
+        m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        LARGE_INTEGER size;
+        if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size)) {
+            close();
+            return false;
+        }
+        m_size = (size_t)size.QuadPart;
+        return map(false);
+#else
+        m_fd = ::open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (m_fd < 0 || fstat(m_fd, &st) != 0) {
+            close();
+            return false;
+        }
+        m_size = (size_t)st.st_size;
+        return map(false);
+#endif
+    }
+
+    bool create(const std::string &path, size_t size) {
+        close();
+        m_size = size;
+#ifdef _WIN32
+        m_file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) {
+            close();
+            return false;
+        }
+        return map(true);
+#else
+        m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (m_fd < 0 || ftruncate(m_fd, (off_t)size) != 0) {
+            close();
+            return false;
+        }
+        return map(true);
+#endif
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (m_data) {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mapping) {
+            CloseHandle(m_mapping);
+        }
+        if (m_file != INVALID_HANDLE_VALUE) {
+            CloseHandle(m_file);
+        }
+        m_file = INVALID_HANDLE_VALUE;
+        m_mapping = nullptr;
+#else
+        if (m_data) {
+            munmap(m_data, m_size);
+        }
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+        m_fd = -1;
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    bool is_open() const {
+        return m_data != nullptr;
+    }
+
+    char *data() {
+        return m_data;
+    }
+
+    const char *data() const {
+        return m_data;
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+private:
+    bool map(bool writable) {
+        if (m_size == 0) {
+            close();
+            return false;
+        }
+#ifdef _WIN32
+        ULARGE_INTEGER size;
+        size.QuadPart = m_size;
+        m_mapping = CreateFileMappingA(m_file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, size.HighPart, size.LowPart, nullptr);
+        if (m_mapping) {
+            m_data = (char *)MapViewOfFile(m_mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, m_size);
+        }
+#else
+        void *data = mmap(nullptr, m_size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, m_fd, 0);
+        m_data = data == MAP_FAILED ? nullptr : (char *)data;
+#endif
+        if (!m_data) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    char *m_data;
+    size_t m_size;
+#ifdef _WIN32
+    HANDLE m_file;
+    HANDLE m_mapping;
+#else
+    int m_fd;
+#endif
+};
@@ -0,0 +1,361 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+
+#include <glbinding/gl/gl.h>
+
+#include "MappedFile.h"
+
+// One attribute inside an interleaved vertex record.
+struct VertexElement {
+    std::string name;
+    gl::GLenum type;
+    gl::GLint dimension;
+    bool normalized;
+    size_t offset;
+};
+
+struct RawMeshHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t vertex_count;
+    std::uint32_t vertex_stride;
+    std::uint32_t element_count;
+    std::uint64_t data_offset;
+};
+
+struct RawMeshElement {
+    char name[32];
+    std::uint32_t type;
+    std::uint32_t dimension;
+    std::uint32_t normalized;
+    std::uint32_t offset;
+};
+
+// Interleaved vertex data of a mesh file, used in place from a mapping:
+// vertex_data() points into the file and is only valid while it is open.
+// Reads binary little-endian PLY and the raw interleaved layout written by
+// write_raw_mesh(). Only vertices are loaded: PLY faces and any other
+// elements after the vertices are ignored, so meshes load as point data.
+class MeshFile {
+public:
+    MeshFile() {
+        m_vertex_data = nullptr;
+        m_vertex_count = 0;
+        m_vertex_stride = 0;
+    }
+
+    bool open(const std::string &path) {
+        close();
+        if (!m_file.open(path)) {
+            return false;
+        }
+        bool success = false;
+        if (m_file.size() >= 4 && std::memcmp(m_file.data(), "ply", 3) == 0
+            && (m_file.data()[3] == '\n' || m_file.data()[3] == '\r')) {
+            success = parse_ply();
+        }
+        else if (m_file.size() >= sizeof(RawMeshHeader) && std::memcmp(m_file.data(), "GLRM", 4) == 0) {
+            success = parse_raw();
+        }
+        if (!success) {
+            close();
+        }
+        return success;
+    }
+
+    void close() {
+        m_file.close();
+        m_elements.clear();
+        m_vertex_data = nullptr;
+        m_vertex_count = 0;
+        m_vertex_stride = 0;
+    }
+
+    const char *vertex_data() const {
+        return m_vertex_data;
+    }
+
+    size_t vertex_count() const {
+        return m_vertex_count;
+    }
+
+    size_t vertex_stride() const {
+        return m_vertex_stride;
+    }
+
+    const std::vector<VertexElement> &elements() const {
+        return m_elements;
+    }
+
+private:
+    struct Property {
+        std::string name;
+        gl::GLenum type;
+        size_t size;
+        size_t offset;
+    };
+
+    bool parse_ply() {
+        const char *begin = m_file.data();
+        const char *end = begin + m_file.size();
+        // The header may use LF or CRLF line endings.
+        static const char end_header[] = "\nend_header";
+        const char *header_end = std::search(begin, end, end_header, end_header + sizeof(end_header) - 1);
+        if (header_end == end) {
+            return false;
+        }
+        const char *data = header_end + sizeof(end_header) - 1;
+        if (data < end && *data == '\r') {
+            ++data;
+        }
+        if (data == end || *data != '\n') {
+            return false;
+        }
+        ++data;
+
+        std::istringstream header(std::string(begin, header_end));
+        std::string line;
+        std::vector<Property> properties;
+        bool binary_le = false;
+        bool in_vertex = false;
+        bool vertex_seen = false;
+        size_t stride = 0;
+        while (std::getline(header, line)) {
+            std::istringstream tokens(line);
+            std::string keyword;
+            tokens >> keyword;
+            if (keyword == "format") {
+                std::string format;
+                tokens >> format;
+                binary_le = format == "binary_little_endian";
+            }
+            else if (keyword == "element") {
+                std::string name;
+                size_t count;
+                tokens >> name >> count;
+                if (!vertex_seen && name != "vertex") {
+                    // Vertex data must come first to be addressable without parsing.
+                    return false;
+                }
+                in_vertex = name == "vertex";
+                if (in_vertex) {
+                    vertex_seen = true;
+                    m_vertex_count = count;
+                }
+            }
+            else if (keyword == "property" && in_vertex) {
+                std::string type, name;
+                tokens >> type;
+                if (type == "list") {
+                    return false;
+                }
+                tokens >> name;
+                Property p;
+                p.name = name;
+                p.offset = stride;
+                if (!ply_type(type, p.type, p.size)) {
+                    return false;
+                }
+                stride += p.size;
+                properties.push_back(p);
+            }
+        }
+        if (!binary_le || !vertex_seen || stride == 0) {
+            return false;
+        }
+
+        m_vertex_stride = stride;
+        m_vertex_data = data;
+        if (m_vertex_count > (size_t)(end - data) / m_vertex_stride) {
+            return false;
+        }
+        group_properties(properties);
+        return true;
+    }
+
+    // Folds consecutive same-typed components (x y z, nx ny nz, red green blue
+    // alpha, u v) into one vector attribute each.
+    void group_properties(const std::vector<Property> &properties) {
+        static const char *groups[][5] = {
+            { "position", "x", "y", "z", nullptr },
+            { "normal", "nx", "ny", "nz", nullptr },
+            { "color", "red", "green", "blue", "alpha" },
+            { "texcoord", "u", "v", nullptr, nullptr },
+            { "texcoord", "s", "t", nullptr, nullptr },
+            { "texcoord", "texture_u", "texture_v", nullptr, nullptr },
+        };
+
+        for (size_t i = 0; i < properties.size();) {
+            VertexElement element;
+            element.name = properties[i].name;
+            element.type = properties[i].type;
+            element.dimension = 1;
+            element.offset = properties[i].offset;
+            for (auto &group : groups) {
+                if (properties[i].name != group[1]) {
+                    continue;
+                }
+                gl::GLint n = 1;
+                while (n < 4 && group[n + 1] && i + n < properties.size()
+                    && properties[i + n].name == group[n + 1] && properties[i + n].type == element.type) {
+                    ++n;
+                }
+                if (n > 1) {
+                    element.name = group[0];
+                    element.dimension = n;
+                }
+                break;
+            }
+            element.normalized = element.name == "color" && element.type != gl::GL_FLOAT && element.type != gl::GL_DOUBLE;
+            m_elements.push_back(element);
+            i += element.dimension;
+        }
+    }
+
+    bool parse_raw() {
+        const RawMeshHeader *header = (const RawMeshHeader *)m_file.data();
+        if (header->version != 1) {
+            return false;
+        }
+        const RawMeshElement *elements = (const RawMeshElement *)(m_file.data() + sizeof(RawMeshHeader));
+        // Sizes come from the file: compare by division so nothing can overflow.
+        std::uint64_t file_size = m_file.size();
+        if (header->element_count > (file_size - sizeof(RawMeshHeader)) / sizeof(RawMeshElement)
+            || header->data_offset > file_size || header->vertex_stride == 0
+            || header->vertex_count > (file_size - header->data_offset) / header->vertex_stride
+            || sizeof(RawMeshHeader) + header->element_count * sizeof(RawMeshElement) > header->data_offset) {
+            return false;
+        }
+        for (std::uint32_t i = 0; i < header->element_count; ++i) {
+            // GL reads each element straight from the mapping: it must be a
+            // known format that ends inside the vertex record.
+            size_t size = element_size((gl::GLenum)elements[i].type, elements[i].dimension);
+            if (size == 0 || elements[i].offset > header->vertex_stride || size > header->vertex_stride - elements[i].offset) {
+                return false;
+            }
+            VertexElement element;
+            element.name = std::string(elements[i].name, strnlen(elements[i].name, sizeof(elements[i].name)));
+            element.type = (gl::GLenum)elements[i].type;
+            element.dimension = (gl::GLint)elements[i].dimension;
+            element.normalized = elements[i].normalized != 0;
+            element.offset = elements[i].offset;
+            m_elements.push_back(element);
+        }
+        m_vertex_count = (size_t)header->vertex_count;
+        m_vertex_stride = header->vertex_stride;
+        m_vertex_data = m_file.data() + header->data_offset;
+        return true;
+    }
+
+    // Bytes taken by one element, or 0 if type and dimension are not a valid
+    // vertex attribute format.
+    static size_t element_size(gl::GLenum type, std::uint32_t dimension) {
+        switch (type) {
+        case gl::GL_INT_2_10_10_10_REV:
+        case gl::GL_UNSIGNED_INT_2_10_10_10_REV:
+            return dimension == 4 ? 4 : 0;
+        case gl::GL_UNSIGNED_INT_10F_11F_11F_REV:
+            return dimension == 3 ? 4 : 0;
+        default:
+            break;
+        }
+        if (dimension < 1 || dimension > 4) {
+            return 0;
+        }
+        switch (type) {
+        case gl::GL_BYTE:
+        case gl::GL_UNSIGNED_BYTE:
+            return dimension;
+        case gl::GL_SHORT:
+        case gl::GL_UNSIGNED_SHORT:
+        case gl::GL_HALF_FLOAT:
+            return 2 * dimension;
+        case gl::GL_INT:
+        case gl::GL_UNSIGNED_INT:
+        case gl::GL_FLOAT:
+            return 4 * dimension;
+        case gl::GL_DOUBLE:
+            return 8 * dimension;
+        default:
+            return 0;
+        }
+    }
+
+    static bool ply_type(const std::string &name, gl::GLenum &type, size_t &size) {
+        if (name == "char" || name == "int8") {
+            type = gl::GL_BYTE;
+            size = 1;
+        }
+        else if (name == "uchar" || name == "uint8") {
+            type = gl::GL_UNSIGNED_BYTE;
+            size = 1;
+        }
+        else if (name == "short" || name == "int16") {
+            type = gl::GL_SHORT;
+            size = 2;
+        }
+        else if (name == "ushort" || name == "uint16") {
+            type = gl::GL_UNSIGNED_SHORT;
+            size = 2;
+        }
+        else if (name == "int" || name == "int32") {
+            type = gl::GL_INT;
+            size = 4;
+        }
+        else if (name == "uint" || name == "uint32") {
+            type = gl::GL_UNSIGNED_INT;
+            size = 4;
+        }
+        else if (name == "float" || name == "float32") {
+            type = gl::GL_FLOAT;
+            size = 4;
+        }
+        else if (name == "double" || name == "float64") {
+            type = gl::GL_DOUBLE;
+            size = 8;
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
+
+    MappedFile m_file;
+    const char *m_vertex_data;
+    size_t m_vertex_count;
+    size_t m_vertex_stride;
+    std::vector<VertexElement> m_elements;
+};
+
+// Writes interleaved vertices in the raw layout read by MeshFile.
+inline bool write_raw_mesh(const std::string &path, const void *vertices, size_t vertex_count, size_t vertex_stride, const std::vector<VertexElement> &elements) {
+    const size_t data_offset = (sizeof(RawMeshHeader) + elements.size() * sizeof(RawMeshElement) + 63) / 64 * 64;
+    MappedFile file;
+    if (!file.create(path, data_offset + vertex_count * vertex_stride)) {
+        return false;
+    }
+    RawMeshHeader *header = (RawMeshHeader *)file.data();
+    std::memcpy(header->magic, "GLRM", 4);
+    header->version = 1;
+    header->vertex_count = vertex_count;
+    header->vertex_stride = (std::uint32_t)vertex_stride;
+    header->element_count = (std::uint32_t)elements.size();
+    header->data_offset = data_offset;
+    RawMeshElement *raw = (RawMeshElement *)(file.data() + sizeof(RawMeshHeader));
+    for (size_t i = 0; i < elements.size(); ++i) {
+        std::memset(raw[i].name, 0, sizeof(raw[i].name));
+        std::strncpy(raw[i].name, elements[i].name.c_str(), sizeof(raw[i].name) - 1);
+        raw[i].type = (std::uint32_t)elements[i].type;
+        raw[i].dimension = (std::uint32_t)elements[i].dimension;
+        raw[i].normalized = elements[i].normalized ? 1 : 0;
+        raw[i].offset = (std::uint32_t)elements[i].offset;
+    }
+    std::memcpy(file.data() + data_offset, vertices, vertex_count * vertex_stride);
+    return true;
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+// A cube of the octree and the range of reordered points it holds.
+struct PointOctreeNode {
+    glm::vec3 min;
+    float size;
+    std::uint32_t first;
+    std::uint32_t count;
+    // Child node index per octant, or -1.
+    std::int32_t children[8];
+};
+
+// Level-of-detail hierarchy for point clouds. Each node holds an evenly
+// spread sample of the points in its cube that its ancestors did not take,
+// so drawing the root plus any set of descendants connected to it refines
+// the cloud from coarse to fine. Points are reordered so that every node's
+// sample is one contiguous range: upload each attribute through reorder()
+// and draw node ranges straight out of one buffer. Nodes hold at most
+// node_capacity points, except leaves at max_depth: their cube can no longer
+// be split, so they take every remaining point (many duplicates, in practice).
+class PointOctree {
+public:
+    static const int max_depth = 21;
+
+    PointOctree() {
+        m_node_capacity = 20000;
+    }
+
+    void build(const std::vector<glm::vec3> &points, size_t node_capacity = 20000) {
+        build(points.data(), points.size(), node_capacity);
+    }
+
+    void build(const glm::vec3 *points, size_t count, size_t node_capacity = 20000) {
+        m_nodes.clear();
+        m_order.clear();
+        if (count == 0) {
+            return;
+        }
+        m_node_capacity = std::max<size_t>(node_capacity, 1);
+
+        glm::vec3 lower = points[0], upper = points[0];
+        for (size_t i = 1; i < count; ++i) {
+            lower = glm::min(lower, points[i]);
+            upper = glm::max(upper, points[i]);
+        }
+        glm::vec3 extent = upper - lower;
+        float size = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-6f));
+
+        // Morton order makes every octant at every depth a contiguous range.
+        std::vector<std::pair<std::uint64_t, std::uint32_t>> sorted(count);
+        const float scale = float((1 << max_depth) - 1) / size;
+        for (size_t i = 0; i < count; ++i) {
+            glm::vec3 cell = (points[i] - lower) * scale;
+            sorted[i].first = morton_code((std::uint32_t)cell.x, (std::uint32_t)cell.y, (std::uint32_t)cell.z);
+            sorted[i].second = (std::uint32_t)i;
+        }
+        std::sort(sorted.begin(), sorted.end());
+
+        m_order.reserve(count);
+        build_node(sorted, 0, count, lower, size, 0);
+    }
+
+    const std::vector<PointOctreeNode> &nodes() const {
+        return m_nodes;
+    }
+
+    // order()[i] is the source index of the i-th reordered point.
+    const std::vector<std::uint32_t> &order() const {
+        return m_order;
+    }
+
+    template <typename T>
+    std::vector<T> reorder(const std::vector<T> &values) const {
+        std::vector<T> result;
+        result.reserve(m_order.size());
+        for (std::uint32_t i : m_order) {
+            result.push_back(values[i]);
+        }
+        return result;
+    }
+
+private:
+    typedef std::vector<std::pair<std::uint64_t, std::uint32_t>> SortedPoints;
+
+    // Takes every stride-th point of [begin, end) for this node, compacts the
+    // rest in place (still in Morton order) and splits it among the children.
+    // At max_depth the node keeps all of [begin, end), whatever its size.
+    std::int32_t build_node(SortedPoints &sorted, size_t begin, size_t end, glm::vec3 min, float size, int depth) {
+        std::int32_t index = (std::int32_t)m_nodes.size();
+        m_nodes.emplace_back();
+        m_nodes[index].min = min;
+        m_nodes[index].size = size;
+        m_nodes[index].first = (std::uint32_t)m_order.size();
+        std::fill(m_nodes[index].children, m_nodes[index].children + 8, -1);
+
+        size_t n = end - begin;
+        if (n <= m_node_capacity || depth == max_depth) {
+            for (size_t i = begin; i < end; ++i) {
+                m_order.push_back(sorted[i].second);
+            }
+            m_nodes[index].count = (std::uint32_t)n;
+            return index;
+        }
+
+        size_t stride = (n + m_node_capacity - 1) / m_node_capacity;
+        size_t rest = begin;
+        for (size_t i = begin; i < end; ++i) {
+            if ((i - begin) % stride == 0) {
+                m_order.push_back(sorted[i].second);
+            }
+            else {
+                sorted[rest++] = sorted[i];
+            }
+        }
+        m_nodes[index].count = (std::uint32_t)(m_order.size() - m_nodes[index].first);
+
+        const int shift = 3 * (max_depth - 1 - depth);
+        float half = size * 0.5f;
+        for (size_t child_begin = begin; child_begin < rest;) {
+            int octant = int((sorted[child_begin].first >> shift) & 7);
+            size_t child_end = child_begin;
+            while (child_end < rest && int((sorted[child_end].first >> shift) & 7) == octant) {
+                ++child_end;
+            }
+            // Morton bits interleave as ...zyx, so bit 0 is x.
+            glm::vec3 child_min = min + glm::vec3(octant & 1 ? half : 0.0f, octant & 2 ? half : 0.0f, octant & 4 ? half : 0.0f);
+            std::int32_t child = build_node(sorted, child_begin, child_end, child_min, half, depth + 1);
+            m_nodes[index].children[octant] = child;
+            child_begin = child_end;
+        }
+        return index;
+    }
+
+    static std::uint64_t spread_bits(std::uint32_t v) {
+        std::uint64_t x = v & 0x1fffff;
+        x = (x | x << 32) & 0x1f00000000ffffull;
+        x = (x | x << 16) & 0x1f0000ff0000ffull;
+        x = (x | x << 8) & 0x100f00f00f00f00full;
+        x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+        x = (x | x << 2) & 0x1249249249249249ull;
+        return x;
+    }
+
+    static std::uint64_t morton_code(std::uint32_t x, std::uint32_t y, std::uint32_t z) {
+        return spread_bits(x) | spread_bits(y) << 1 | spread_bits(z) << 2;
+    }
+
+    size_t m_node_capacity;
+    std::vector<PointOctreeNode> m_nodes;
+    std::vector<std::uint32_t> m_order;
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "GLTypeTraits.h"
+#include "MappedFile.h"
+
+// Self-describing container for lossless render results: a fixed header
+// followed by frame_count tightly packed frames, each stored bottom row first
+// exactly as glReadPixels returns them for the internal format. Every frame
+// starts on a 64-byte boundary (frame_stride is the frame size rounded up),
+// so the whole file can be mapped and used in place.
+struct RawImageHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t format;
+    std::uint32_t pixel_size;
+    std::uint64_t frame_count;
+    std::uint64_t data_offset;
+    std::uint64_t frame_stride;
+};
+
+class RawImageFile {
+public:
+    static const std::uint32_t current_version = 2;
+    static const std::uint64_t header_size = 64;
+    static const std::uint64_t frame_alignment = 64;
+
+    bool create(const std::string &path, int width, int height, gl::GLenum format, size_t frame_count = 1) {
+        size_t pixel_size = pixel_format(format).size;
+        if (pixel_size == 0 || width <= 0 || height <= 0 || frame_count == 0) {
+            return false;
+        }
+        std::uint64_t frame_size, frame_stride, data_size, file_size;
+        if (!checked_multiply((std::uint64_t)width * (std::uint64_t)height, pixel_size, frame_size)
+            || !checked_add(frame_size, frame_alignment - 1, frame_stride)) {
+            return false;
+        }
+        frame_stride -= frame_stride % frame_alignment;
+        if (!checked_multiply(frame_stride, frame_count, data_size) || !checked_add(header_size, data_size, file_size)
+            || file_size > (std::uint64_t)SIZE_MAX) {
+            return false;
+        }
+        if (!m_file.create(path, (size_t)file_size)) {
+            return false;
+        }
+        RawImageHeader *header = (RawImageHeader *)m_file.data();
+        std::memcpy(header->magic, "GLRI", 4);
+        header->version = current_version;
+        header->width = (std::uint32_t)width;
+        header->height = (std::uint32_t)height;
+        header->format = (std::uint32_t)format;
+        header->pixel_size = (std::uint32_t)pixel_size;
+        header->frame_count = frame_count;
+        header->data_offset = header_size;
+        header->frame_stride = frame_stride;
+        return true;
+    }
+
+    bool open(const std::string &path) {
+        if (!m_file.open(path)) {
+            return false;
+        }
+        if (m_file.size() < header_size || !valid_header(*(const RawImageHeader *)m_file.data(), m_file.size())) {
+            m_file.close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        m_file.close();
+    }
+
+    const RawImageHeader &header() const {
+        return *(const RawImageHeader *)m_file.data();
+    }
+
+    int width() const {
+        return (int)header().width;
+    }
+
+    int height() const {
+        return (int)header().height;
+    }
+
+    gl::GLenum format() const {
+        return (gl::GLenum)header().format;
+    }
+
+    size_t frame_count() const {
+        return (size_t)header().frame_count;
+    }
+
+    size_t frame_size() const {
+        return (size_t)header().width * header().height * header().pixel_size;
+    }
+
+    size_t frame_stride() const {
+        return (size_t)header().frame_stride;
+    }
+
+    // Only writable for files made with create().
+    void *frame(size_t i) {
+        return m_file.data() + header().data_offset + frame_stride() * i;
+    }
+
+    const void *frame(size_t i) const {
+        return m_file.data() + header().data_offset + frame_stride() * i;
+    }
+
+private:
+    // Every size in the header comes from the file, so all arithmetic on it
+    // is overflow-checked before it is compared against the file size.
+    static bool valid_header(const RawImageHeader &h, size_t file_size) {
+        std::uint64_t frame_size, data_size, end;
+        return std::memcmp(h.magic, "GLRI", 4) == 0 && h.version == current_version
+            && h.pixel_size != 0 && h.pixel_size == pixel_format((gl::GLenum)h.format).size
+            && checked_multiply((std::uint64_t)h.width * (std::uint64_t)h.height, h.pixel_size, frame_size)
+            && h.frame_stride >= frame_size && h.frame_stride % frame_alignment == 0
+            && h.data_offset >= header_size && h.data_offset % frame_alignment == 0
+            && checked_multiply(h.frame_stride, h.frame_count, data_size)
+            && checked_add(h.data_offset, data_size, end) && end <= file_size;
+    }
+
+    static bool checked_multiply(std::uint64_t a, std::uint64_t b, std::uint64_t &result) {
+        if (a != 0 && b > UINT64_MAX / a) {
+            return false;
+        }
+        result = a * b;
+        return true;
+    }
+
+    static bool checked_add(std::uint64_t a, std::uint64_t b, std::uint64_t &result) {
+        if (b > UINT64_MAX - a) {
+            return false;
+        }
+        result = a + b;
+        return true;
+    }
+
+    MappedFile m_file;
+};
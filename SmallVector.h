@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+// Vector keeping its first N elements inside the object, so descriptors that
+// rarely exceed N (attributes, attachments, shader declarations) cost no
+// allocation beyond their owner's. Grows onto the heap past N. Move-only;
+// iterators are invalidated by any insertion, as with std::vector.
+template <typename T, size_t N>
+class SmallVector {
+public:
+    typedef T value_type;
+    typedef T *iterator;
+    typedef const T *const_iterator;
+
+    SmallVector() {
+        m_data = inline_data();
+        m_size = 0;
+        m_capacity = N;
+    }
+
+    SmallVector(const SmallVector &) = delete;
+    SmallVector &operator=(const SmallVector &) = delete;
+
+    SmallVector(SmallVector &&other) : SmallVector() {
+        take(other);
+    }
+
+    SmallVector &operator=(SmallVector &&other) {
+        if (this != &other) {
+            clear();
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    ~SmallVector() {
+        clear();
+        release();
+    }
+
+    template <typename... Args>
+    T &emplace_back(Args &&...args) {
+        if (m_size == m_capacity) {
+            // Construct first: args may refer to an element about to move.
+            T value(std::forward<Args>(args)...);
+            grow(m_capacity * 2);
+            new (m_data + m_size) T(std::move(value));
+        }
+        else {
+            new (m_data + m_size) T(std::forward<Args>(args)...);
+        }
+        return m_data[m_size++];
+    }
+
+    void push_back(const T &value) {
+        emplace_back(value);
+    }
+
+    void push_back(T &&value) {
+        emplace_back(std::move(value));
+    }
+
+    iterator insert(const_iterator position, T &&value) {
+        size_t index = position - m_data;
+        emplace_back(std::move(value));
+        for (size_t i = m_size - 1; i > index; --i) {
+            std::swap(m_data[i], m_data[i - 1]);
+        }
+        return m_data + index;
+    }
+
+    void clear() {
+        for (size_t i = 0; i < m_size; ++i) {
+            m_data[i].~T();
+        }
+        m_size = 0;
+    }
+
+    void reserve(size_t capacity) {
+        if (capacity > m_capacity) {
+            grow(capacity);
+        }
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+    size_t capacity() const {
+        return m_capacity;
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    T &operator[](size_t i) {
+        return m_data[i];
+    }
+
+    const T &operator[](size_t i) const {
+        return m_data[i];
+    }
+
+    T &back() {
+        return m_data[m_size - 1];
+    }
+
+    const T &back() const {
+        return m_data[m_size - 1];
+    }
+
+    T *data() {
+        return m_data;
+    }
+
+    const T *data() const {
+        return m_data;
+    }
+
+    iterator begin() {
+        return m_data;
+    }
+
+    iterator end() {
+        return m_data + m_size;
+    }
+
+    const_iterator begin() const {
+        return m_data;
+    }
+
+    const_iterator end() const {
+        return m_data + m_size;
+    }
+
+private:
+    T *inline_data() {
+        return reinterpret_cast<T *>(&m_storage);
+    }
+
+    void grow(size_t capacity) {
+        T *data = static_cast<T *>(::operator new(capacity * sizeof(T)));
+        for (size_t i = 0; i < m_size; ++i) {
+            new (data + i) T(std::move(m_data[i]));
+            m_data[i].~T();
+        }
+        release();
+        m_data = data;
+        m_capacity = capacity;
+    }
+
+    void release() {
+        if (m_data != inline_data()) {
+            ::operator delete(m_data);
+        }
+        m_data = inline_data();
+        m_capacity = N;
+    }
+
+    // Expects this to be empty and inline.
+    void take(SmallVector &other) {
+        if (other.m_data != other.inline_data()) {
+            m_data = other.m_data;
+            m_capacity = other.m_capacity;
+            m_size = other.m_size;
+            other.m_data = other.inline_data();
+            other.m_capacity = N;
+            other.m_size = 0;
+            return;
+        }
+        for (size_t i = 0; i < other.m_size; ++i) {
+            new (m_data + i) T(std::move(other.m_data[i]));
+        }
+        m_size = other.m_size;
+        other.clear();
+    }
+
+    typename std::aligned_storage<sizeof(T) * N, alignof(T)>::type m_storage;
+    T *m_data;
+    size_t m_size;
+    size_t m_capacity;
+};
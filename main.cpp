@@ -1,10 +1,27 @@
 #include <vector>
-#include <map>
 #include <memory>
 #include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <type_traits>
+#include <ctime>
+
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include <glm/glm.hpp>
 #include <glbinding/gl/gl.h>
+#include <glbinding/gl/extension.h>
 #include <globjects/globjects.h>
 
 #include <globjects/Texture.h>
@@ -23,45 +40,143 @@
 #include <opencv2/opencv.hpp>
 
 #include "GLTypeTraits.h"
+#include "GLSLLayout.h"
+#include "BoundedQueue.h"
+#include "RawImageFile.h"
+#include "MeshFile.h"
+#include "CommandList.h"
+#include "SmallVector.h"
+#include "InternedString.h"
+#include "PointOctree.h"
 #include "HeadlessGL.h"
 
+#ifdef GLRENDERER_COUNT_ALLOCATIONS
+// Counts every global operator new so a steady-state frame can be checked
+// for zero allocations: compare allocation_count() before and after it.
+static std::atomic<size_t> g_allocation_count(0);
+
+void *operator new(size_t size) {
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+#endif
+
+// Always 0 unless built with GLRENDERER_COUNT_ALLOCATIONS.
+inline size_t allocation_count() {
+#ifdef GLRENDERER_COUNT_ALLOCATIONS
+    return g_allocation_count.load(std::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
 class Geometry {
     struct Attribute {
         gl::GLsizei size;
         gl::GLint element_stride;
+        gl::GLint offset;
         gl::GLenum element_type;
         gl::GLint dimension;
+        gl::GLboolean normalized;
         gl::GLint location;
         bool enabled;
-        std::string glsl_type;
+        const char *glsl_type;
         globjects::ref_ptr<globjects::Buffer> buffer;
     };
 
 public:
+    // Uploads larger than this are streamed with glBufferSubData, which keeps
+    // the driver's staging memory bounded for multi-GB sources.
+    static const size_t upload_chunk_size = 64 << 20;
+
     Geometry() {
         m_attribute_updated = false;
+        m_primitive = gl::GL_TRIANGLES;
+    }
+
+    void set_primitive(gl::GLenum mode) {
+        m_primitive = mode;
     }
 
     template <typename T>
     void add_attribute(const std::vector<T> &data, gl::GLenum usage = gl::GL_STATIC_DRAW) {
-        size_t location = m_attributes.size();
-        m_attributes.emplace_back(std::make_unique<Attribute>());
-        std::unique_ptr<Attribute> &att = m_attributes[location];
-        att->buffer = globjects::make_ref<globjects::Buffer>();
-        att->buffer->setData(data, usage);
-        att->element_stride = sizeof(T);
-        att->element_type = GLTypeTraits<typename GLTypeTraits<T>::element_type>::opengl_enum;
-        att->dimension = gl::GLint(GLTypeTraits<T>::dimension);
-        att->glsl_type = GLTypeTraits<T>::glsl_type();
-        att->size = (gl::GLsizei)data.size();
-        att->location = 0;
-        att->enabled = false;
-        m_attribute_updated = true;
+        add_attribute(data.data(), data.size(), usage);
+    }
+
+    template <typename T>
+    void add_attribute(const T *data, size_t count, gl::GLenum usage = gl::GL_STATIC_DRAW) {
+        size_t buffer = add_buffer(data, count * sizeof(T), usage);
+        add_attribute<T>(buffer, 0, sizeof(T), count);
+    }
+
+    // A tightly packed T per vertex, read from an existing buffer at offset/stride.
+    template <typename T>
+    void add_attribute(size_t buffer, size_t offset, size_t stride, size_t count) {
+        Attribute &att = append_attribute(buffer, offset, stride, count);
+        att.element_type = GLTypeTraits<typename GLTypeTraits<T>::element_type>::opengl_enum;
+        att.dimension = gl::GLint(GLTypeTraits<T>::dimension);
+        att.normalized = is_normalized<T>::value ? gl::GL_TRUE : gl::GL_FALSE;
+        att.glsl_type = GLTypeTraits<T>::glsl_type();
+    }
+
+    void add_attribute(size_t buffer, const VertexElement &element, size_t stride, size_t count) {
+        Attribute &att = append_attribute(buffer, element.offset, stride, count);
+        att.element_type = element.type;
+        att.dimension = element.dimension;
+        att.normalized = element.normalized ? gl::GL_TRUE : gl::GL_FALSE;
+    }
+
+    size_t add_buffer(const void *data, size_t size, gl::GLenum usage = gl::GL_STATIC_DRAW) {
+        globjects::ref_ptr<globjects::Buffer> buffer = globjects::make_ref<globjects::Buffer>();
+        if (size <= upload_chunk_size) {
+            buffer->setData((gl::GLsizeiptr)size, data, usage);
+        }
+        else {
+            buffer->setData((gl::GLsizeiptr)size, nullptr, usage);
+            for (size_t offset = 0; offset < size; offset += upload_chunk_size) {
+                size_t chunk = std::min(upload_chunk_size, size - offset);
+                buffer->setSubData((const char *)data + offset, (gl::GLsizeiptr)chunk, (gl::GLintptr)offset);
+            }
+        }
+        m_buffers.push_back(buffer);
+        return m_buffers.size() - 1;
+    }
+
+    // Adopts a buffer filled elsewhere, e.g. by an AsyncLoader.
+    size_t add_buffer(globjects::ref_ptr<globjects::Buffer> buffer) {
+        m_buffers.push_back(buffer);
+        return m_buffers.size() - 1;
+    }
+
+    // Uploads the interleaved vertices of a mapped mesh file as one buffer and
+    // adds one attribute per element, in order. The file can be closed after.
+    // MeshFile carries no connectivity, so the geometry is drawn as points
+    // unless primitive says otherwise.
+    void add_mesh(const MeshFile &mesh, gl::GLenum usage = gl::GL_STATIC_DRAW, gl::GLenum primitive = gl::GL_POINTS) {
+        m_primitive = primitive;
+        size_t buffer = add_buffer(mesh.vertex_data(), mesh.vertex_count() * mesh.vertex_stride(), usage);
+        for (const VertexElement &element : mesh.elements()) {
+            add_attribute(buffer, element, mesh.vertex_stride(), mesh.vertex_count());
+        }
+    }
+
+    template <typename Layout, size_t Input, typename T>
+    void add_attribute(const std::vector<T> &data, gl::GLenum usage = gl::GL_STATIC_DRAW) {
+        static_assert(Layout::template accepts_attribute<Input, T>(), "attribute type does not match the vertex input at this location");
+        add_attribute(data, usage);
+        bind_attribute_input(int(m_attributes.size() - 1), int(Input));
     }
 
     void bind_attribute_input(int attribute, int input, bool enabled = true) {
-        m_attributes[attribute]->location = input;
-        m_attributes[attribute]->enabled = enabled;
+        m_attributes[attribute].location = input;
+        m_attributes[attribute].enabled = enabled;
         m_attribute_updated = true;
     }
 
@@ -70,30 +185,146 @@ public:
             m_attribute_updated = false;
             prepare();
         }
-        m_vertexarray->drawArrays(gl::GL_TRIANGLES, 0, m_attributes[0]->size);
+        m_vertexarray->drawArrays(m_primitive, 0, m_attributes[0].size);
+    }
+
+    // Enables draw_lod() for point attributes uploaded in the octree's order,
+    // e.g. add_attribute(octree.reorder(points)).
+    void set_lod(const PointOctree &octree) {
+        m_lod_nodes = octree.nodes();
+    }
+
+    // Draws the octree nodes worth drawing this frame as points, largest on
+    // screen first, until point_budget points are drawn. Nodes outside the
+    // frustum and nodes under min_node_pixels on screen are skipped with
+    // their subtrees. The root is drawn whenever it is in view, even if its
+    // sample alone exceeds point_budget, so coarse detail stays visible.
+    // Returns the number of points drawn.
+    size_t draw_lod(const glm::mat4 &view, const glm::mat4 &projection, int viewport_height, size_t point_budget, float min_node_pixels = 30.0f) {
+        if (m_lod_nodes.empty()) {
+            return 0;
+        }
+        if (m_attribute_updated) {
+            m_attribute_updated = false;
+            prepare();
+        }
+
+        glm::mat4 view_projection = projection * view;
+        glm::vec4 planes[6];
+        for (int i = 0; i < 3; ++i) {
+            glm::vec4 row(view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]);
+            glm::vec4 w(view_projection[0][3], view_projection[1][3], view_projection[2][3], view_projection[3][3]);
+            planes[2 * i] = w + row;
+            planes[2 * i + 1] = w - row;
+        }
+        // Pixels per unit of radius at distance 1 (or at any distance if orthographic).
+        float pixels_per_unit = projection[1][1] * viewport_height * 0.5f;
+        bool perspective = projection[3][3] == 0.0f;
+
+        m_lod_queue.clear();
+        m_lod_first.clear();
+        m_lod_count.clear();
+        LODEntry root;
+        if (lod_priority(0, view, planes, pixels_per_unit, perspective, root.priority)) {
+            root.node = 0;
+            m_lod_queue.push_back(root);
+        }
+
+        size_t drawn = 0;
+        while (!m_lod_queue.empty()) {
+            std::pop_heap(m_lod_queue.begin(), m_lod_queue.end());
+            std::int32_t index = m_lod_queue.back().node;
+            const PointOctreeNode &node = m_lod_nodes[index];
+            m_lod_queue.pop_back();
+            if (index != 0 && drawn + node.count > point_budget) {
+                continue;
+            }
+            if (node.count > 0) {
+                m_lod_first.push_back((gl::GLint)node.first);
+                m_lod_count.push_back((gl::GLsizei)node.count);
+                drawn += node.count;
+            }
+            for (std::int32_t child : node.children) {
+                LODEntry entry;
+                if (child >= 0 && lod_priority(child, view, planes, pixels_per_unit, perspective, entry.priority)
+                    && entry.priority >= min_node_pixels) {
+                    entry.node = child;
+                    m_lod_queue.push_back(entry);
+                    std::push_heap(m_lod_queue.begin(), m_lod_queue.end());
+                }
+            }
+        }
+
+        if (!m_lod_first.empty()) {
+            m_vertexarray->multiDrawArrays(gl::GL_POINTS, m_lod_first.data(), m_lod_count.data(), (gl::GLsizei)m_lod_first.size());
+        }
+        return drawn;
     }
 
 private:
+    struct LODEntry {
+        float priority;
+        std::int32_t node;
+
+        bool operator<(const LODEntry &other) const {
+            return priority < other.priority;
+        }
+    };
+
+    // Projected diameter in pixels of the node's bounding sphere; false if
+    // the sphere is outside the frustum.
+    bool lod_priority(std::int32_t index, const glm::mat4 &view, const glm::vec4 *planes, float pixels_per_unit, bool perspective, float &priority) const {
+        const PointOctreeNode &node = m_lod_nodes[index];
+        glm::vec3 center = node.min + glm::vec3(node.size * 0.5f);
+        float radius = node.size * 0.8660254f;
+        for (int i = 0; i < 6; ++i) {
+            glm::vec3 normal(planes[i].x, planes[i].y, planes[i].z);
+            if (glm::dot(normal, center) + planes[i].w < -radius * glm::length(normal)) {
+                return false;
+            }
+        }
+        if (!perspective) {
+            priority = 2.0f * radius * pixels_per_unit;
+            return true;
+        }
+        float distance = -(view * glm::vec4(center, 1.0f)).z;
+        priority = distance > radius ? 2.0f * radius * pixels_per_unit / distance : std::numeric_limits<float>::max();
+        return true;
+    }
+
+    Attribute &append_attribute(size_t buffer, size_t offset, size_t stride, size_t count) {
+        Attribute &att = m_attributes.emplace_back();
+        att.buffer = m_buffers[buffer];
+        att.offset = (gl::GLint)offset;
+        att.element_stride = (gl::GLint)stride;
+        att.size = (gl::GLsizei)count;
+        att.location = 0;
+        att.enabled = false;
+        att.glsl_type = nullptr;
+        m_attribute_updated = true;
+        return att;
+    }
+
     void prepare() {
         if (!m_vertexarray) {
             m_vertexarray = globjects::make_ref<globjects::VertexArray>();
         }
 
         for (size_t i = 0; i < m_attributes.size(); ++i) {
-            const std::unique_ptr<Attribute> &att = m_attributes[i];
+            const Attribute &att = m_attributes[i];
             globjects::VertexAttributeBinding *binding = m_vertexarray->binding((gl::GLuint)i);
-            binding->setAttribute(att->location);
-            binding->setBuffer(att->buffer, 0, att->element_stride);
-            if (att->element_type == gl::GL_FLOAT) {
-                binding->setFormat(att->dimension, gl::GL_FLOAT);
+            binding->setAttribute(att.location);
+            binding->setBuffer(att.buffer, att.offset, att.element_stride);
+            if (att.element_type == gl::GL_DOUBLE) {
+                binding->setLFormat(att.dimension, gl::GL_DOUBLE);
             }
-            else if (att->element_type == gl::GL_DOUBLE) {
-                binding->setLFormat(att->dimension, gl::GL_DOUBLE);
+            else if (att.normalized == gl::GL_TRUE || is_float_format(att.element_type)) {
+                binding->setFormat(att.dimension, att.element_type, att.normalized);
             }
             else {
-                binding->setIFormat(att->dimension, m_attributes[i]->element_type);
+                binding->setIFormat(att.dimension, att.element_type);
             }
-            if (att->enabled) {
+            if (att.enabled) {
                 m_vertexarray->enable((gl::GLint)i);
             }
             else {
@@ -102,9 +333,23 @@ private:
         }
     }
 
+    static bool is_float_format(gl::GLenum type) {
+        return type == gl::GL_FLOAT || type == gl::GL_HALF_FLOAT
+            || type == gl::GL_INT_2_10_10_10_REV || type == gl::GL_UNSIGNED_INT_2_10_10_10_REV
+            || type == gl::GL_UNSIGNED_INT_10F_11F_11F_REV;
+    }
+
     bool m_attribute_updated;
-    std::vector<std::unique_ptr<Attribute>> m_attributes;
+    SmallVector<globjects::ref_ptr<globjects::Buffer>, 4> m_buffers;
+    SmallVector<Attribute, 4> m_attributes;
     globjects::ref_ptr<globjects::VertexArray> m_vertexarray;
+    gl::GLenum m_primitive;
+
+    // Kept across frames so draw_lod() stops allocating once warmed up.
+    std::vector<PointOctreeNode> m_lod_nodes;
+    std::vector<LODEntry> m_lod_queue;
+    std::vector<gl::GLint> m_lod_first;
+    std::vector<gl::GLsizei> m_lod_count;
 };
 
 class Pass {
@@ -113,77 +358,190 @@ public:
         m_viewport_w = m_viewport_h = 0;
         m_state = globjects::make_ref<globjects::State>(globjects::State::DeferredMode);
         m_shader_updated = false;
+        m_vshader_layout = "";
+        m_fshader_layout = "";
+        m_bindless = false;
+        m_textures_updated = false;
+        m_has_depth = false;
+        m_vshader_stale = false;
+        m_fshader_stale = false;
+        m_vshader_file.modified = m_fshader_file.modified = 0;
+        m_vshader_file.size = m_fshader_file.size = 0;
+        m_transparency = Transparency::none;
+        m_max_fragments = 8;
+        m_max_node_bytes = 256 << 20;
+        m_transparency_updated = false;
+    }
+
+    ~Pass() {
+        for (auto &input : m_fshader_textures) {
+            release_texture(input);
+        }
     }
 
     template <typename T>
     void add_color_attachment(const std::string name, bool use_rbo = false) {
-        add_color_attachment(name, typename GLTypeTraits<T>::color_enum(), use_rbo);
+        add_color_attachment(name, GLTypeTraits<T>::color_enum(), use_rbo);
     }
 
     void add_color_attachment(const std::string &name, gl::GLenum type, bool use_rbo = false) {
-        m_colors.emplace_back(std::make_unique<Attachment>());
-        m_colors.back()->name = name;
-        m_colors.back()->is_texture = !use_rbo;
-        m_colors.back()->type = type;
-        m_colors.back()->create();
-
-        GLSLVariable &var = m_fshader_outputs[m_colors.size() - 1];
-        var.name = name;
+        create_color_attachment(name, type, use_rbo);
+
+        GLSLVariable &var = variable_at(m_fshader_outputs, m_colors.size() - 1);
+        var.name = intern(name);
         var.type = glsl_type(type);
 
         m_viewport_w = m_viewport_h = 0;
-        m_shader_updated = true;
+        mark_shader_updated(false, true);
     }
 
     void add_depth_attachment(const gl::GLenum type = gl::GL_DEPTH_COMPONENT32F, bool use_rbo = true) {
-        if (!m_depth) {
-            m_depth = std::make_unique<Attachment>();
-        }
-        m_depth->is_texture = !use_rbo;
-        m_depth->type = type;
-        m_depth->create();
+        m_has_depth = true;
+        m_depth.is_texture = !use_rbo;
+        m_depth.type = type;
+        m_depth.create();
         m_viewport_w = m_viewport_h = 0;
     }
 
     template <typename T>
     void add_vshader_uniform(const std::string &name) {
         GLSLVariable var;
-        var.name = name;
+        var.name = intern(name);
         var.type = GLTypeTraits<T>::glsl_type();
         m_vshader_uniforms.push_back(var);
-        m_shader_updated = true;
+        mark_shader_updated(true, false);
     }
 
     template <typename T>
     void add_fshader_uniform(const std::string &name) {
         GLSLVariable var;
-        var.name = name;
+        var.name = intern(name);
         var.type = GLTypeTraits<T>::glsl_type();
         m_fshader_uniforms.push_back(var);
-        m_shader_updated = true;
+        mark_shader_updated(false, true);
     }
 
     template <typename T>
     void add_vshader_input(size_t location, const std::string &name) {
-        GLSLVariable &var = m_vshader_inputs[location];
-        var.name = name;
+        GLSLVariable &var = variable_at(m_vshader_inputs, location);
+        var.name = intern(name);
         var.type = GLTypeTraits<T>::glsl_type();
-        m_shader_updated = true;
+        mark_shader_updated(true, false);
     }
 
     template <typename T>
     void add_vfshader_interface(const std::string &name) {
         GLSLVariable var;
-        var.name = name;
+        var.name = intern(name);
         var.type = GLTypeTraits<T>::glsl_type();
         m_vfshader_interfaces.push_back(var);
-        m_shader_updated = true;
+        mark_shader_updated(true, true);
+    }
+
+    // Samples texture as T (sampler2D, isampler2D or usampler2D) under name.
+    // Units are assigned in declaration order; with ARB_bindless_texture the
+    // resident handles are passed in one uniform block instead.
+    template <typename T>
+    void add_fshader_texture(const std::string &name, globjects::ref_ptr<globjects::Texture> texture) {
+        TextureInput input;
+        input.name = intern(name);
+        input.sampler = glsl_sampler_type<T>();
+        input.texture = texture;
+        input.handle = 0;
+        m_fshader_textures.push_back(input);
+        mark_shader_updated(false, true);
+        m_textures_updated = true;
+    }
+
+    // Swaps the texture behind an existing declaration without recompiling.
+    void set_fshader_texture(const std::string &name, globjects::ref_ptr<globjects::Texture> texture) {
+        for (auto &input : m_fshader_textures) {
+            if (input.name == name) {
+                release_texture(input);
+                input.texture = texture;
+                m_textures_updated = true;
+            }
+        }
     }
 
+    // Replaces the color attachments and prepends the layout's precomputed
+    // declarations; declarations added through add_* are still appended.
+    template <typename Layout>
+    void set_layout() {
+        static constexpr auto vshader_declarations = Layout::vshader_declarations();
+        static constexpr auto fshader_declarations = Layout::fshader_declarations();
+        m_vshader_layout = vshader_declarations.c_str();
+        m_fshader_layout = fshader_declarations.c_str();
+
+        m_colors.clear();
+        m_fshader_outputs.clear();
+        Layout::for_each_output([this](size_t, const char *name, gl::GLenum type) {
+            create_color_attachment(name, type, false);
+        });
+
+        m_viewport_w = m_viewport_h = 0;
+        mark_shader_updated(true, true);
+    }
+
+    // Only a stage whose source changed is recompiled.
     void set_shader(const std::string &vs, const std::string &fs) {
+        m_vshader_file.path.clear();
+        m_fshader_file.path.clear();
+        mark_shader_updated(vs != m_vshader_source, fs != m_fshader_source);
         m_vshader_source = vs;
         m_fshader_source = fs;
-        m_shader_updated = true;
+    }
+
+    // Like set_shader() with each main() body read from a file. The files are
+    // watched by polling their modification time from begin(), at most every
+    // shader_poll_interval_ms; a stage is recompiled only when its file changed.
+    bool set_shader_files(const std::string &vs_path, const std::string &fs_path) {
+        m_vshader_file.path = vs_path;
+        m_fshader_file.path = fs_path;
+        m_vshader_file.modified = m_fshader_file.modified = 0;
+        m_vshader_file.size = m_fshader_file.size = 0;
+        m_last_shader_poll = std::chrono::steady_clock::time_point();
+        poll_shader_files();
+        if (m_vshader_file.modified == 0 || m_fshader_file.modified == 0) {
+            std::cout << "Pass: cannot read shader files " << vs_path << ", " << fs_path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    static const int shader_poll_interval_ms = 250;
+
+    enum class Transparency {
+        none,
+        // Per-pixel fragment lists, sorted and composited in end().
+        linked_lists,
+        // Weighted blended OIT: approximate, but fixed memory and no sorting.
+        weighted_blended
+    };
+
+    // Composites everything drawn between begin() and end() as transparent,
+    // with no sorting of primitives. The first color output is the fragment's
+    // straight-alpha color; the composite is blended over the first color
+    // attachment's clear color in end(). Depth is tested but not written.
+    // The first color output must be a vec4; otherwise the pass stays opaque.
+    // Linked lists keep the max_fragments nearest fragments of each pixel and
+    // reserve storage for max_fragments per pixel on average, but never more
+    // than max_node_bytes (16 bytes per fragment); fragments past the pool
+    // are dropped. Weighted blending draws to two targets after the color
+    // attachments; fails, keeping the current mode, if the context has too
+    // few draw buffers for them.
+    bool set_transparency(Transparency mode, int max_fragments = 8, size_t max_node_bytes = 256 << 20) {
+        if (mode == Transparency::weighted_blended && !oit_targets_fit()) {
+            std::cout << "Pass: weighted blended transparency needs " << m_colors.size() + 2 << " draw buffers, more than supported" << std::endl;
+            return false;
+        }
+        m_transparency = mode;
+        m_max_fragments = max_fragments;
+        m_max_node_bytes = max_node_bytes;
+        m_transparency_updated = true;
+        m_oit_resolve = nullptr;
+        mark_shader_updated(false, true);
+        return true;
     }
 
     globjects::State* state() {
@@ -192,8 +550,22 @@ public:
 
     template <typename T>
     void set_uniform(const std::string &name, const T &value) {
+        set_uniform(name.c_str(), value);
+    }
+
+    // Allocation-free once the name has been seen (for values up to a mat4):
+    // locations are cached per program, so replaying recorded uniforms builds
+    // no std::string. The value is kept and re-applied whenever the program
+    // is rebuilt.
+    template <typename T>
+    void set_uniform(const char *name, const T &value) {
+        Uniform &u = uniform(name);
+        store_uniform(u, value, std::integral_constant<bool, std::is_trivially_copyable<T>::value && sizeof(T) <= sizeof(Uniform::value)>());
+        u.apply = [](globjects::Program *program, gl::GLint location, const void *value) {
+            program->setUniform(location, *static_cast<const T *>(value));
+        };
         if (m_program) {
-            m_program->setUniform(name, value);
+            m_program->setUniform(u.location, value);
         }
     }
 
@@ -202,6 +574,16 @@ public:
             m_viewport_w = w;
             m_viewport_h = h;
             prepare_framebuffer();
+            m_transparency_updated = true;
+        }
+
+        if (m_transparency_updated && transparent()) {
+            m_transparency_updated = false;
+            prepare_transparency();
+        }
+
+        if (!m_vshader_file.path.empty() || !m_fshader_file.path.empty()) {
+            poll_shader_files();
         }
 
         if (m_shader_updated) {
@@ -209,42 +591,223 @@ public:
             prepare_shader();
         }
 
+        if (m_textures_updated) {
+            m_textures_updated = false;
+            prepare_textures();
+        }
+
         m_framebuffer->bind();
         if (m_program) {
             m_program->use();
         }
         m_state->apply();
+        bind_textures();
 
         gl::glViewport(0, 0, w, h);
         m_framebuffer->clear(gl::GL_COLOR_BUFFER_BIT | gl::GL_DEPTH_BUFFER_BIT);
+
+        if (transparent()) {
+            begin_transparency();
+        }
     }
 
     void end() {
+        if (transparent()) {
+            resolve_transparency();
+        }
         m_framebuffer->unbind();
     }
 
     void show_color_attachment(size_t id) {
-        m_colors[id]->show(m_viewport_w, m_viewport_h);
+        m_colors[id].show(m_viewport_w, m_viewport_h);
+    }
+
+    int width() const {
+        return m_viewport_w;
+    }
+
+    int height() const {
+        return m_viewport_h;
+    }
+
+    gl::GLenum color_attachment_type(size_t id) const {
+        return m_colors[id].type;
+    }
+
+    template <typename T>
+    std::vector<T> read_color_attachment(size_t id) {
+        assert(sizeof(T) == pixel_format(m_colors[id].type).size);
+        std::vector<T> result((size_t)m_viewport_w * m_viewport_h);
+        read_color_attachment(id, result.data());
+        return result;
+    }
+
+    // With a buffer bound to GL_PIXEL_PACK_BUFFER, data is an offset into it.
+    void read_color_attachment(size_t id, void *data) {
+        read_region((int)id, 0, 0, m_viewport_w, m_viewport_h, m_viewport_w, data);
+    }
+
+    // Reads straight into caller memory, e.g. a frame of a mapped RawImageFile.
+    void read_depth_attachment(void *data) {
+        read_region(depth_output, 0, 0, m_viewport_w, m_viewport_h, m_viewport_w, data);
+    }
+
+    gl::GLenum depth_attachment_type() const {
+        return m_depth.type;
+    }
+
+    static const int depth_output = -1;
+
+    struct TileOutput {
+        int attachment;
+        void *data;
+    };
+
+    // Largest square framebuffer the implementation can render into.
+    static int max_tile_size() {
+        gl::GLint texture_size = 0, renderbuffer_size = 0, viewport[2] = { 0, 0 };
+        gl::glGetIntegerv(gl::GL_MAX_TEXTURE_SIZE, &texture_size);
+        gl::glGetIntegerv(gl::GL_MAX_RENDERBUFFER_SIZE, &renderbuffer_size);
+        gl::glGetIntegerv(gl::GL_MAX_VIEWPORT_DIMS, viewport);
+        return std::min(std::min(texture_size, renderbuffer_size), std::min(viewport[0], viewport[1]));
+    }
+
+    // Renders a width x height image as tile x tile pieces through one
+    // tile-sized framebuffer. draw() issues the draw calls for a tile and must
+    // apply the given matrix after the projection (clip = tile * proj * view).
+    // Each tile is read back in place into every output, which holds the whole
+    // image of its attachment (depth_output for depth) bottom row first, e.g.
+    // a mapped RawImageFile frame; memory use is bounded by the tile size.
+    // Fails if no tile size is usable, e.g. with no context current.
+    bool render_tiled(int width, int height, int tile, const std::function<void(const glm::mat4 &)> &draw, const std::vector<TileOutput> &outputs) {
+        tile = std::min(tile, max_tile_size());
+        if (tile <= 0) {
+            std::cout << "Pass: render_tiled needs a positive tile size" << std::endl;
+            return false;
+        }
+        for (int y = 0; y < height; y += tile) {
+            for (int x = 0; x < width; x += tile) {
+                begin(tile, tile);
+                draw(tile_transform(x, y, tile, width, height));
+                // Resolves transparency before the outputs are read.
+                end();
+                for (const TileOutput &output : outputs) {
+                    GLPixelFormat format = pixel_format(output.attachment == depth_output ? m_depth.type : m_colors[output.attachment].type);
+                    char *origin = (char *)output.data + ((size_t)y * width + x) * format.size;
+                    read_region(output.attachment, 0, 0, std::min(tile, width - x), std::min(tile, height - y), width, origin);
+                }
+            }
+        }
+        return true;
+    }
+
+    // Maps the clip space of the full image onto the tile at pixel (x, y).
+    static glm::mat4 tile_transform(int x, int y, int tile, int width, int height) {
+        glm::mat4 transform(1.0f);
+        transform[0][0] = float(width) / tile;
+        transform[1][1] = float(height) / tile;
+        transform[3][0] = float(width - 2 * x - tile) / tile;
+        transform[3][1] = float(height - 2 * y - tile) / tile;
+        return transform;
     }
 
 private:
+    void read_region(int attachment, int x, int y, int w, int h, int row_length, void *data) {
+        GLPixelFormat format;
+        if (attachment == depth_output) {
+            format = pixel_format(m_depth.type);
+        }
+        else {
+            format = pixel_format(m_colors[attachment].type);
+            m_framebuffer->setReadBuffer(gl::GL_COLOR_ATTACHMENT0 + attachment);
+        }
+        gl::glPixelStorei(gl::GL_PACK_ALIGNMENT, 1);
+        gl::glPixelStorei(gl::GL_PACK_ROW_LENGTH, row_length == w ? 0 : row_length);
+        m_framebuffer->readPixels(x, y, w, h, format.format, format.type, data);
+        gl::glPixelStorei(gl::GL_PACK_ROW_LENGTH, 0);
+    }
+
+    struct Uniform {
+        const char *name;
+        gl::GLint location;
+        void (*apply)(globjects::Program *, gl::GLint, const void *);
+        // Large enough for a mat4; anything bigger or not trivially copyable
+        // (arrays, std::vector, dmat4) is boxed instead.
+        std::aligned_storage<64>::type value;
+        std::shared_ptr<void> boxed;
+
+        const void *data() const {
+            return boxed ? boxed.get() : &value;
+        }
+    };
+
+    template <typename T>
+    static void store_uniform(Uniform &u, const T &value, std::true_type) {
+        u.boxed = nullptr;
+        std::memcpy(&u.value, &value, sizeof(T));
+    }
+
+    template <typename T>
+    static void store_uniform(Uniform &u, const T &value, std::false_type) {
+        u.boxed = std::make_shared<T>(value);
+    }
+
+    Uniform &uniform(const char *name) {
+        for (Uniform &u : m_uniforms) {
+            if (u.name == name || std::strcmp(u.name, name) == 0) {
+                return u;
+            }
+        }
+        Uniform &u = m_uniforms.emplace_back();
+        u.name = intern(name);
+        u.location = m_program ? m_program->getUniformLocation(u.name) : -1;
+        u.apply = nullptr;
+        return u;
+    }
+
+    // Locations change with the program; the cached values carry over.
+    void restore_uniforms() {
+        for (Uniform &u : m_uniforms) {
+            u.location = m_program->getUniformLocation(u.name);
+            if (u.apply) {
+                u.apply(m_program.get(), u.location, u.data());
+            }
+        }
+    }
+
+    struct TextureInput {
+        const char *name;
+        const char *sampler;
+        globjects::ref_ptr<globjects::Texture> texture;
+        gl::GLuint64 handle;
+    };
+
+    void create_color_attachment(const std::string &name, gl::GLenum type, bool use_rbo) {
+        Attachment &attachment = m_colors.emplace_back();
+        attachment.name = intern(name);
+        attachment.is_texture = !use_rbo;
+        attachment.type = type;
+        attachment.create();
+    }
+
     void prepare_framebuffer() {
         if (!m_framebuffer) {
             m_framebuffer = globjects::make_ref<globjects::Framebuffer>();
         }
 
         for (size_t i = 0; i < m_colors.size(); ++i) {
-            m_colors[i]->storage(m_viewport_w, m_viewport_h);
-            m_colors[i]->attach(m_framebuffer.get(), gl::GL_COLOR_ATTACHMENT0 + (int)i);
+            m_colors[i].storage(m_viewport_w, m_viewport_h);
+            m_colors[i].attach(m_framebuffer.get(), gl::GL_COLOR_ATTACHMENT0 + (int)i);
         }
 
-        if (m_depth) {
-            m_depth->storage(m_viewport_w, m_viewport_h);
-            m_depth->attach(m_framebuffer.get(), gl::GL_DEPTH_ATTACHMENT);
+        if (m_has_depth) {
+            m_depth.storage(m_viewport_w, m_viewport_h);
+            m_depth.attach(m_framebuffer.get(), gl::GL_DEPTH_ATTACHMENT);
         }
 
         if (m_colors.size() > 0) {
             std::vector<gl::GLenum> draw_buffers;
+            draw_buffers.reserve(m_colors.size());
             for (size_t i = 0; i < m_colors.size(); ++i) {
                 draw_buffers.push_back(gl::GL_COLOR_ATTACHMENT0 + (int)i);
             }
@@ -257,54 +820,416 @@ private:
         m_framebuffer->printStatus(true);
     }
 
+    void mark_shader_updated(bool vshader, bool fshader) {
+        m_vshader_stale = m_vshader_stale || vshader;
+        m_fshader_stale = m_fshader_stale || fshader;
+        m_shader_updated = m_shader_updated || vshader || fshader;
+    }
+
+    // Recompiles the stale stages and links them with the current shader of
+    // the other stage into a new program. The new program only replaces the
+    // current one once it links, so a bad edit leaves the last working
+    // program active; failed stages stay stale and are retried on the next
+    // change. Uniform values set so far are re-applied to the new program.
     void prepare_shader() {
-        if (!m_program) {
-            m_program = globjects::make_ref<globjects::Program>();
+        bool bindless = !m_fshader_textures.empty() && globjects::hasExtension(gl::GLextension::GL_ARB_bindless_texture);
+        if (bindless != m_bindless) {
+            m_fshader_stale = true;
         }
-        std::string vshader_code = "#version 430\n";
-        std::string fshader_code = "#version 430\n";
 
-        for (auto &v : m_vshader_uniforms) {
-            vshader_code += v.declaration_line("uniform");
+        bool compiled = true;
+        globjects::ref_ptr<globjects::Shader> vshader = m_vshader;
+        globjects::ref_ptr<globjects::Shader> fshader = m_fshader;
+        if (m_vshader_stale || !vshader) {
+            vshader = globjects::Shader::fromString(gl::GL_VERTEX_SHADER, vshader_code());
+            compiled = vshader->compile() && compiled;
         }
-        for (auto &f : m_fshader_uniforms) {
-            fshader_code += f.declaration_line("uniform");
+        if (m_fshader_stale || !fshader) {
+            fshader = globjects::Shader::fromString(gl::GL_FRAGMENT_SHADER, fshader_code(bindless));
+            compiled = fshader->compile() && compiled;
+        }
+        if (!compiled) {
+            std::cout << "Pass: shader compilation failed, keeping the previous program" << std::endl;
+            return;
+        }
+
+        globjects::ref_ptr<globjects::Program> program = globjects::make_ref<globjects::Program>();
+        program->attach(vshader.get(), fshader.get());
+        program->link();
+        if (program->infoLog().size() > 0) {
+            std::cout << program->infoLog() << std::endl;
+        }
+        if (!program->isLinked()) {
+            std::cout << "Pass: program link failed, keeping the previous program" << std::endl;
+            return;
+        }
+
+        m_program = program;
+        restore_uniforms();
+        m_vshader = vshader;
+        m_fshader = fshader;
+        m_vshader_stale = m_fshader_stale = false;
+        m_bindless = bindless;
+        m_textures_updated = true;
+        if (!m_bindless) {
+            for (size_t i = 0; i < m_fshader_textures.size(); ++i) {
+                m_program->setUniform(m_fshader_textures[i].name, (gl::GLint)i);
+            }
         }
+    }
 
+    std::string vshader_code() {
+        std::string code = "#version 430\n";
+        code += m_vshader_layout;
+        for (auto &v : m_vshader_uniforms) {
+            code += v.declaration_line("uniform");
+        }
         for (auto &v : m_vshader_inputs) {
             std::string layout = "location = " + std::to_string(v.first);
-            vshader_code += v.second.declaration_line("in", layout);
+            code += v.second.declaration_line("in", layout);
         }
-
         for (auto &v : m_vfshader_interfaces) {
-            char c = v.type[0];
-            if(c=='b' ||c =='u'||c=='i') {
-                vshader_code += "flat ";
-                fshader_code += "flat ";
-            }
-            vshader_code += v.declaration_line("out");
-            fshader_code += v.declaration_line("in");
+            code += v.interpolation_qualifier();
+            code += v.declaration_line("out");
         }
+        code += "void main() {\n\t" + m_vshader_source + "\n}";
+        return code;
+    }
 
+    std::string fshader_code(bool bindless) {
+        std::string code = "#version 430\n";
+        if (bindless) {
+            code += "#extension GL_ARB_bindless_texture : require\n";
+        }
+        code += m_fshader_layout;
+        for (auto &f : m_fshader_uniforms) {
+            code += f.declaration_line("uniform");
+        }
+        for (auto &v : m_vfshader_interfaces) {
+            code += v.interpolation_qualifier();
+            code += v.declaration_line("in");
+        }
         for (auto &f : m_fshader_outputs) {
             std::string layout = "location = " + std::to_string(f.first);
-            fshader_code += f.second.declaration_line("out", layout);
+            code += f.second.declaration_line("out", layout);
+        }
+
+        if (bindless) {
+            code += "layout(std140, binding = " + std::to_string(texture_block_binding) + ") uniform PassTextures {\n";
+            for (auto &t : m_fshader_textures) {
+                code += std::string("\t") + t.sampler + " " + t.name + ";\n";
+            }
+            code += "};\n";
+        }
+        else {
+            for (auto &t : m_fshader_textures) {
+                code += std::string("uniform ") + t.sampler + " " + t.name + ";\n";
+            }
+        }
+        if (!transparent()) {
+            if (m_transparency != Transparency::none) {
+                std::cout << "Pass: transparency needs a vec4 first color output, drawing opaque" << std::endl;
+            }
+            code += "void main() {\n\t" + m_fshader_source + "\n}";
+            return code;
+        }
+        code += transparency_declarations();
+        code += "void pass_main() {\n\t" + m_fshader_source + "\n}\n";
+        code += std::string("void main() {\n\tpass_main();\n\toit_store(") + m_colors[0].name + ");\n}";
+        return code;
+    }
+
+    // Fragment-stage storage for transparent fragments, consumed by the
+    // resolve pass in end(). Colors are stored as 8-bit RGBA in the lists.
+    bool oit_targets_fit() const {
+        gl::GLint draw_buffers = 0, color_attachments = 0;
+        gl::glGetIntegerv(gl::GL_MAX_DRAW_BUFFERS, &draw_buffers);
+        gl::glGetIntegerv(gl::GL_MAX_COLOR_ATTACHMENTS, &color_attachments);
+        return m_colors.size() + 2 <= (size_t)std::min(draw_buffers, color_attachments);
+    }
+
+    // oit_store() takes the first color output as a straight-alpha vec4.
+    bool transparent() const {
+        return m_transparency != Transparency::none && !m_colors.empty() && std::strcmp(glsl_type(m_colors[0].type), "vec4") == 0;
+    }
+
+    std::string transparency_declarations() {
+        if (m_transparency == Transparency::linked_lists) {
+            return "layout(early_fragment_tests) in;\n"
+                + oit_list_declarations()
+                + "layout(binding = " + std::to_string(oit_counter_binding) + ", offset = 0) uniform atomic_uint oit_counter;\n"
+                "void oit_store(vec4 color) {\n"
+                "\tif (color.a <= 0.0) {\n\t\treturn;\n\t}\n"
+                "\tuint index = atomicCounterIncrement(oit_counter);\n"
+                "\tif (index >= uint(oit_nodes.length())) {\n\t\treturn;\n\t}\n"
+                "\toit_nodes[index].color = packUnorm4x8(color);\n"
+                "\toit_nodes[index].depth = gl_FragCoord.z;\n"
+                "\toit_nodes[index].next = imageAtomicExchange(oit_heads, ivec2(gl_FragCoord.xy), index);\n"
+                "}\n";
+        }
+        // McGuire and Bavoil 2013, eq. 10 weights.
+        size_t accum = m_colors.size();
+        return "layout(location = " + std::to_string(accum) + ") out vec4 oit_accum;\n"
+            "layout(location = " + std::to_string(accum + 1) + ") out float oit_revealage;\n"
+            "void oit_store(vec4 color) {\n"
+            "\tfloat weight = clamp(pow(min(1.0, color.a * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);\n"
+            "\toit_accum = vec4(color.rgb * color.a, color.a) * weight;\n"
+            "\toit_revealage = color.a;\n"
+            "}\n";
+    }
+
+    static std::string oit_list_declarations() {
+        return "struct OITNode {\n\tuint color;\n\tfloat depth;\n\tuint next;\n\tuint unused;\n};\n"
+            "layout(std430, binding = " + std::to_string(oit_nodes_binding) + ") buffer OITNodes {\n\tOITNode oit_nodes[];\n};\n"
+            "layout(binding = " + std::to_string(oit_image_unit) + ", r32ui) uniform coherent uimage2D oit_heads;\n";
+    }
+
+    void prepare_transparency() {
+        if (m_transparency == Transparency::linked_lists) {
+            m_oit_heads = globjects::make_ref<globjects::Texture>(gl::GL_TEXTURE_2D);
+            m_oit_heads->storage2D(1, gl::GL_R32UI, m_viewport_w, m_viewport_h);
+            m_oit_counter = globjects::make_ref<globjects::Buffer>();
+            m_oit_counter->setData(sizeof(gl::GLuint), nullptr, gl::GL_DYNAMIC_COPY);
+            m_oit_nodes = globjects::make_ref<globjects::Buffer>();
+            size_t nodes = std::min((size_t)m_viewport_w * m_viewport_h * m_max_fragments, m_max_node_bytes / oit_node_size);
+            m_oit_nodes->setData((gl::GLsizeiptr)(std::max<size_t>(nodes, 1) * oit_node_size), nullptr, gl::GL_DYNAMIC_COPY);
+            return;
+        }
+
+        // The color attachments may have grown since set_transparency().
+        if (!oit_targets_fit()) {
+            std::cout << "Pass: too many color attachments for weighted blended transparency, drawing opaque" << std::endl;
+            m_transparency = Transparency::none;
+            mark_shader_updated(false, true);
+            return;
+        }
+
+        // Accumulation targets follow the color attachments, so the pass's
+        // own outputs map to GL_NONE while transparent geometry is drawn.
+        size_t accum = m_colors.size();
+        m_oit_accum = globjects::make_ref<globjects::Texture>(gl::GL_TEXTURE_2D);
+        m_oit_accum->storage2D(1, gl::GL_RGBA16F, m_viewport_w, m_viewport_h);
+        m_oit_revealage = globjects::make_ref<globjects::Texture>(gl::GL_TEXTURE_2D);
+        m_oit_revealage->storage2D(1, gl::GL_R16F, m_viewport_w, m_viewport_h);
+        m_oit_framebuffer = globjects::make_ref<globjects::Framebuffer>();
+        m_oit_framebuffer->attachTexture(gl::GL_COLOR_ATTACHMENT0 + (int)accum, m_oit_accum);
+        m_oit_framebuffer->attachTexture(gl::GL_COLOR_ATTACHMENT0 + (int)accum + 1, m_oit_revealage);
+        if (m_has_depth) {
+            m_depth.attach(m_oit_framebuffer.get(), gl::GL_DEPTH_ATTACHMENT);
+        }
+        std::vector<gl::GLenum> draw_buffers(accum, gl::GL_NONE);
+        draw_buffers.push_back(gl::GL_COLOR_ATTACHMENT0 + (int)accum);
+        draw_buffers.push_back(gl::GL_COLOR_ATTACHMENT0 + (int)accum + 1);
+        m_oit_framebuffer->setDrawBuffers(draw_buffers);
+        m_oit_framebuffer->printStatus(true);
+    }
+
+    void begin_transparency() {
+        gl::glDepthMask(gl::GL_FALSE);
+        if (m_transparency == Transparency::linked_lists) {
+            // The last frame's image stores and counter increments must land
+            // before the clear and the counter reset overwrite them.
+            gl::glMemoryBarrier(gl::GL_TEXTURE_UPDATE_BARRIER_BIT | gl::GL_BUFFER_UPDATE_BARRIER_BIT | gl::GL_ATOMIC_COUNTER_BARRIER_BIT);
+            m_oit_heads->clearImage(0, gl::GL_RED_INTEGER, gl::GL_UNSIGNED_INT, glm::uvec4(oit_end_of_list));
+            gl::GLuint zero = 0;
+            m_oit_counter->setSubData(&zero, sizeof(zero));
+            m_oit_heads->bindImageTexture(oit_image_unit, 0, gl::GL_FALSE, 0, gl::GL_READ_WRITE, gl::GL_R32UI);
+            m_oit_counter->bindBase(gl::GL_ATOMIC_COUNTER_BUFFER, oit_counter_binding);
+            m_oit_nodes->bindBase(gl::GL_SHADER_STORAGE_BUFFER, oit_nodes_binding);
+            gl::glColorMask(gl::GL_FALSE, gl::GL_FALSE, gl::GL_FALSE, gl::GL_FALSE);
+            return;
+        }
+
+        size_t accum = m_colors.size();
+        m_oit_framebuffer->bind();
+        m_oit_framebuffer->clearBuffer(gl::GL_COLOR, (gl::GLint)accum, glm::vec4(0.0f));
+        m_oit_framebuffer->clearBuffer(gl::GL_COLOR, (gl::GLint)accum + 1, glm::vec4(1.0f));
+        gl::glEnable(gl::GL_BLEND);
+        gl::glBlendFunci((gl::GLuint)accum, gl::GL_ONE, gl::GL_ONE);
+        gl::glBlendFunci((gl::GLuint)accum + 1, gl::GL_ZERO, gl::GL_ONE_MINUS_SRC_COLOR);
+    }
+
+    // Blends the composite of the transparent fragments over the first color
+    // attachment with a fullscreen triangle. Leaves blending and the depth
+    // test disabled and depth and color writes enabled.
+    void resolve_transparency() {
+        if (m_transparency == Transparency::linked_lists) {
+            gl::glMemoryBarrier(gl::GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | gl::GL_SHADER_STORAGE_BARRIER_BIT);
+            gl::glColorMask(gl::GL_TRUE, gl::GL_TRUE, gl::GL_TRUE, gl::GL_TRUE);
+        }
+        else {
+            m_framebuffer->bind();
+            m_oit_accum->bindActive(0);
+            m_oit_revealage->bindActive(1);
+        }
+        if (!m_oit_resolve) {
+            m_oit_resolve = create_resolve_program();
+        }
+        if (!m_oit_vertexarray) {
+            m_oit_vertexarray = globjects::make_ref<globjects::VertexArray>();
+        }
+
+        for (size_t i = 1; i < m_colors.size(); ++i) {
+            gl::glColorMaski((gl::GLuint)i, gl::GL_FALSE, gl::GL_FALSE, gl::GL_FALSE, gl::GL_FALSE);
+        }
+        gl::glDisable(gl::GL_DEPTH_TEST);
+        gl::glEnable(gl::GL_BLEND);
+        gl::glBlendFunc(gl::GL_ONE, gl::GL_ONE_MINUS_SRC_ALPHA);
+        m_oit_resolve->use();
+        m_oit_vertexarray->drawArrays(gl::GL_TRIANGLES, 0, 3);
+
+        for (size_t i = 1; i < m_colors.size(); ++i) {
+            gl::glColorMaski((gl::GLuint)i, gl::GL_TRUE, gl::GL_TRUE, gl::GL_TRUE, gl::GL_TRUE);
+        }
+        gl::glDisable(gl::GL_BLEND);
+        gl::glDepthMask(gl::GL_TRUE);
+    }
+
+    globjects::ref_ptr<globjects::Program> create_resolve_program() {
+        std::string vshader_code = "#version 430\n"
+            "void main() {\n"
+            "\tvec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+            "\tgl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);\n"
+            "}";
+
+        std::string fshader_code = "#version 430\n";
+        if (m_transparency == Transparency::linked_lists) {
+            // Keeps the n nearest fragments sorted by insertion, then
+            // composites them back to front.
+            std::string n = std::to_string(m_max_fragments);
+            fshader_code += oit_list_declarations()
+                + "layout(location = 0) out vec4 oit_color;\n"
+                "void main() {\n"
+                "\tuint colors[" + n + "];\n"
+                "\tfloat depths[" + n + "];\n"
+                "\tint count = 0;\n"
+                "\tuint index = imageLoad(oit_heads, ivec2(gl_FragCoord.xy)).r;\n"
+                "\twhile (index != " + std::to_string(oit_end_of_list) + "u) {\n"
+                "\t\tOITNode node = oit_nodes[index];\n"
+                "\t\tindex = node.next;\n"
+                "\t\tif (count == " + n + " && node.depth >= depths[" + n + " - 1]) {\n\t\t\tcontinue;\n\t\t}\n"
+                "\t\tint i = min(count, " + n + " - 1);\n"
+                "\t\twhile (i > 0 && depths[i - 1] > node.depth) {\n"
+                "\t\t\tcolors[i] = colors[i - 1];\n"
+                "\t\t\tdepths[i] = depths[i - 1];\n"
+                "\t\t\t--i;\n"
+                "\t\t}\n"
+                "\t\tcolors[i] = node.color;\n"
+                "\t\tdepths[i] = node.depth;\n"
+                "\t\tcount = min(count + 1, " + n + ");\n"
+                "\t}\n"
+                "\tif (count == 0) {\n\t\tdiscard;\n\t}\n"
+                "\tvec4 result = vec4(0.0);\n"
+                "\tfor (int i = count - 1; i >= 0; --i) {\n"
+                "\t\tvec4 c = unpackUnorm4x8(colors[i]);\n"
+                "\t\tresult = vec4(c.rgb * c.a, c.a) + result * (1.0 - c.a);\n"
+                "\t}\n"
+                "\toit_color = result;\n"
+                "}";
+        }
+        else {
+            fshader_code += "layout(binding = 0) uniform sampler2D oit_accum;\n"
+                "layout(binding = 1) uniform sampler2D oit_revealage;\n"
+                "layout(location = 0) out vec4 oit_color;\n"
+                "void main() {\n"
+                "\tivec2 p = ivec2(gl_FragCoord.xy);\n"
+                "\tfloat revealage = texelFetch(oit_revealage, p, 0).r;\n"
+                "\tif (revealage >= 1.0) {\n\t\tdiscard;\n\t}\n"
+                "\tvec4 accum = texelFetch(oit_accum, p, 0);\n"
+                "\toit_color = vec4(accum.rgb / max(accum.a, 1e-5), 1.0) * (1.0 - revealage);\n"
+                "}";
+        }
+
+        globjects::ref_ptr<globjects::Shader> vshader = globjects::Shader::fromString(gl::GL_VERTEX_SHADER, vshader_code);
+        globjects::ref_ptr<globjects::Shader> fshader = globjects::Shader::fromString(gl::GL_FRAGMENT_SHADER, fshader_code);
+        globjects::ref_ptr<globjects::Program> program = globjects::make_ref<globjects::Program>();
+        program->attach(vshader.get(), fshader.get());
+        program->link();
+        if (program->infoLog().size() > 0) {
+            std::cout << program->infoLog() << std::endl;
+        }
+        return program;
+    }
+
+    struct ShaderFile {
+        std::string path;
+        time_t modified;
+        long long size;
+    };
+
+    void poll_shader_files() {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now - m_last_shader_poll < std::chrono::milliseconds(shader_poll_interval_ms)) {
+            return;
+        }
+        m_last_shader_poll = now;
+        bool vshader = reload_shader_file(m_vshader_file, m_vshader_source);
+        bool fshader = reload_shader_file(m_fshader_file, m_fshader_source);
+        mark_shader_updated(vshader, fshader);
+    }
+
+    // True if the file changed on disk and its content differs from source.
+    // Unreadable files, e.g. mid-save, are picked up on a later poll.
+    static bool reload_shader_file(ShaderFile &file, std::string &source) {
+        struct stat st;
+        if (file.path.empty() || stat(file.path.c_str(), &st) != 0) {
+            return false;
+        }
+        if (st.st_mtime == file.modified && (long long)st.st_size == file.size) {
+            return false;
+        }
+        std::ifstream in(file.path, std::ios::binary);
+        if (!in) {
+            return false;
         }
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        file.modified = st.st_mtime;
+        file.size = (long long)st.st_size;
+        if (text == source) {
+            return false;
+        }
+        source = text;
+        return true;
+    }
 
-        vshader_code += "void main() {\n\t" + m_vshader_source + "\n}";
-        fshader_code += "void main() {\n\t" + m_fshader_source + "\n}";
+    void prepare_textures() {
+        if (!m_bindless) {
+            return;
+        }
+        std::vector<gl::GLuint64> handles;
+        for (auto &input : m_fshader_textures) {
+            if (input.handle == 0) {
+                globjects::TextureHandle handle = input.texture->textureHandle();
+                handle.makeResident();
+                input.handle = handle.handle();
+            }
+            handles.push_back(input.handle);
+        }
+        if (!m_texture_handles) {
+            m_texture_handles = globjects::make_ref<globjects::Buffer>();
+        }
+        m_texture_handles->setData(handles, gl::GL_STATIC_DRAW);
+    }
+
+    void bind_textures() {
+        if (m_bindless) {
+            m_texture_handles->bindBase(gl::GL_UNIFORM_BUFFER, texture_block_binding);
+            return;
+        }
+        for (size_t i = 0; i < m_fshader_textures.size(); ++i) {
+            m_fshader_textures[i].texture->bindActive((gl::GLuint)i);
+        }
+    }
 
-        m_vshader = globjects::Shader::fromString(gl::GL_VERTEX_SHADER, vshader_code);
-        m_fshader = globjects::Shader::fromString(gl::GL_FRAGMENT_SHADER, fshader_code);
-        m_program->attach(m_vshader.get(), m_fshader.get());
-        m_program->link();
-        if (m_program->infoLog().size()>0) {
-            std::cout << m_program->infoLog() << std::endl;
+    void release_texture(TextureInput &input) {
+        if (input.handle != 0) {
+            input.texture->textureHandle().makeNonResident();
+            input.handle = 0;
         }
     }
 
     struct Attachment {
-        std::string name;
+        const char *name;
         bool is_texture;
         gl::GLenum type;
         globjects::ref_ptr<globjects::Texture> texture;
@@ -345,9 +1270,10 @@ private:
         }
     };
 
+    // type and name point at static or interned strings.
     struct GLSLVariable {
-        std::string type;
-        std::string name;
+        const char *type;
+        const char *name;
 
         std::string declaration_line(const std::string &qualifier, const std::string &layout = "") {
             std::string result;
@@ -357,29 +1283,502 @@ private:
             result += qualifier + " " + type + " " + name + ";\n";
             return result;
         }
+
+        // Integer interfaces cannot be interpolated.
+        const char *interpolation_qualifier() const {
+            char c = type[0];
+            return c == 'b' || c == 'u' || c == 'i' ? "flat " : "";
+        }
     };
 
+    // Declarations keyed by location, kept sorted by location.
+    typedef SmallVector<std::pair<size_t, GLSLVariable>, 8> LocatedVariables;
+
+    static GLSLVariable &variable_at(LocatedVariables &variables, size_t location) {
+        auto it = std::lower_bound(variables.begin(), variables.end(), location,
+            [](const std::pair<size_t, GLSLVariable> &v, size_t l) { return v.first < l; });
+        if (it == variables.end() || it->first != location) {
+            it = variables.insert(it, std::make_pair(location, GLSLVariable()));
+        }
+        return it->second;
+    }
+
     int m_viewport_w;
     int m_viewport_h;
 
-    std::vector<std::unique_ptr<Attachment>> m_colors;
-    std::unique_ptr<Attachment> m_depth;
+    SmallVector<Attachment, 4> m_colors;
+    Attachment m_depth;
+    bool m_has_depth;
     globjects::ref_ptr<globjects::Framebuffer> m_framebuffer;
 
     globjects::ref_ptr<globjects::State> m_state;
 
     bool m_shader_updated;
-    std::vector<GLSLVariable> m_vshader_uniforms;
-    std::vector<GLSLVariable> m_fshader_uniforms;
-    std::map<size_t, GLSLVariable> m_vshader_inputs;
-    std::vector<GLSLVariable> m_vfshader_interfaces;
-    std::map<size_t, GLSLVariable> m_fshader_outputs;
+    bool m_vshader_stale;
+    bool m_fshader_stale;
+    const char *m_vshader_layout;
+    const char *m_fshader_layout;
+    SmallVector<GLSLVariable, 8> m_vshader_uniforms;
+    SmallVector<GLSLVariable, 8> m_fshader_uniforms;
+    LocatedVariables m_vshader_inputs;
+    SmallVector<GLSLVariable, 8> m_vfshader_interfaces;
+    LocatedVariables m_fshader_outputs;
+
+    static const gl::GLuint texture_block_binding = 0;
+    bool m_bindless;
+    bool m_textures_updated;
+    SmallVector<TextureInput, 4> m_fshader_textures;
+    globjects::ref_ptr<globjects::Buffer> m_texture_handles;
 
     std::string m_vshader_source;
     std::string m_fshader_source;
+    ShaderFile m_vshader_file;
+    ShaderFile m_fshader_file;
+    std::chrono::steady_clock::time_point m_last_shader_poll;
+
+    static const gl::GLuint oit_image_unit = 0;
+    static const gl::GLuint oit_counter_binding = 0;
+    static const gl::GLuint oit_nodes_binding = 1;
+    static const gl::GLuint oit_end_of_list = 0xFFFFFFFFu;
+    static const size_t oit_node_size = 16;
+    Transparency m_transparency;
+    int m_max_fragments;
+    size_t m_max_node_bytes;
+    bool m_transparency_updated;
+    globjects::ref_ptr<globjects::Texture> m_oit_heads;
+    globjects::ref_ptr<globjects::Buffer> m_oit_counter;
+    globjects::ref_ptr<globjects::Buffer> m_oit_nodes;
+    globjects::ref_ptr<globjects::Texture> m_oit_accum;
+    globjects::ref_ptr<globjects::Texture> m_oit_revealage;
+    globjects::ref_ptr<globjects::Framebuffer> m_oit_framebuffer;
+    globjects::ref_ptr<globjects::Program> m_oit_resolve;
+    globjects::ref_ptr<globjects::VertexArray> m_oit_vertexarray;
     globjects::ref_ptr<globjects::Shader> m_vshader;
     globjects::ref_ptr<globjects::Shader> m_fshader;
     globjects::ref_ptr<globjects::Program> m_program;
+    SmallVector<Uniform, 8> m_uniforms;
+};
+
+// Overlaps rendering, readback and encoding of long frame sequences. Each
+// pushed frame is read back asynchronously into a ring of pixel-pack buffers;
+// once its fence has passed it is copied into a pooled frame and handed to
+// the encoder threads through a bounded queue. When every pooled frame is in
+// flight, push() waits for the encoders (backpressure).
+class FrameStream {
+public:
+    struct Frame {
+        size_t index;
+        int width;
+        int height;
+        gl::GLenum type;
+        std::vector<unsigned char> pixels;
+    };
+
+    struct Stats {
+        size_t frames_pushed;
+        size_t frames_encoded;
+        size_t producer_stalls;
+        double seconds;
+
+        double frames_per_second() const {
+            return seconds > 0.0 ? frames_encoded / seconds : 0.0;
+        }
+    };
+
+    typedef std::function<void(const Frame &)> Encoder;
+
+    FrameStream(Encoder encoder, size_t n_workers = 2, size_t ring_size = 3, size_t queue_capacity = 8) :
+        m_encoder(encoder), m_ring(ring_size), m_free(queue_capacity), m_ready(queue_capacity) {
+        // push() waits for encoded frames, so at least one encoder must run.
+        if (n_workers == 0) {
+            std::cout << "FrameStream: n_workers must be at least 1, using 1" << std::endl;
+            n_workers = 1;
+        }
+        m_frames.resize(m_free.capacity());
+        for (auto &frame : m_frames) {
+            frame = std::make_unique<Frame>();
+            m_free.try_push(frame.get());
+        }
+        for (auto &slot : m_ring) {
+            slot.buffer = globjects::make_ref<globjects::Buffer>();
+            slot.fence = nullptr;
+            slot.capacity = 0;
+        }
+        m_next_slot = 0;
+        m_frames_pushed = 0;
+        m_frames_encoded = 0;
+        m_producer_stalls = 0;
+        m_stopping = false;
+        for (size_t i = 0; i < n_workers; ++i) {
+            m_workers.emplace_back(&FrameStream::work, this);
+        }
+    }
+
+    ~FrameStream() {
+        finish();
+    }
+
+    // Call after Pass::end(), on the GL thread.
+    void push(Pass *pass, size_t attachment) {
+        if (m_frames_pushed == 0) {
+            m_start = std::chrono::steady_clock::now();
+        }
+
+        Slot &slot = m_ring[m_next_slot];
+        m_next_slot = (m_next_slot + 1) % m_ring.size();
+        if (slot.fence) {
+            retire(slot);
+        }
+
+        slot.index = m_frames_pushed++;
+        slot.width = pass->width();
+        slot.height = pass->height();
+        slot.type = pass->color_attachment_type(attachment);
+        slot.size = (size_t)slot.width * slot.height * pixel_format(slot.type).size;
+        if (slot.size > slot.capacity) {
+            slot.buffer->setData((gl::GLsizeiptr)slot.size, nullptr, gl::GL_STREAM_READ);
+            slot.capacity = slot.size;
+        }
+
+        slot.buffer->bind(gl::GL_PIXEL_PACK_BUFFER);
+        pass->read_color_attachment(attachment, nullptr);
+        globjects::Buffer::unbind(gl::GL_PIXEL_PACK_BUFFER);
+        slot.fence = gl::glFenceSync(gl::GL_SYNC_GPU_COMMANDS_COMPLETE, gl::GL_UNUSED_BIT);
+    }
+
+    // Drains the ring and the queue and stops the encoders. Call on the GL thread.
+    void finish() {
+        if (m_workers.empty()) {
+            return;
+        }
+        for (size_t i = 0; i < m_ring.size(); ++i) {
+            Slot &slot = m_ring[m_next_slot];
+            m_next_slot = (m_next_slot + 1) % m_ring.size();
+            if (slot.fence) {
+                retire(slot);
+            }
+        }
+        m_stopping = true;
+        for (auto &worker : m_workers) {
+            worker.join();
+        }
+        m_workers.clear();
+        m_end = std::chrono::steady_clock::now();
+    }
+
+    Stats stats() const {
+        Stats stats;
+        stats.frames_pushed = m_frames_pushed;
+        stats.frames_encoded = m_frames_encoded;
+        stats.producer_stalls = m_producer_stalls;
+        std::chrono::steady_clock::time_point end = m_workers.empty() ? m_end : std::chrono::steady_clock::now();
+        stats.seconds = m_frames_pushed > 0 ? std::chrono::duration<double>(end - m_start).count() : 0.0;
+        return stats;
+    }
+
+    // Writes each frame with OpenCV; the extension of the printf-style pattern
+    // picks the codec, e.g. "frame_%06zu.png" for 8/16-bit or ".exr" for float.
+    static Encoder image_writer(const std::string &pattern) {
+        return [pattern](const Frame &frame) {
+            GLPixelFormat format = pixel_format(frame.type);
+            int depth = cv_depth(format.type);
+            int channels = gl_channels(format.format);
+            if (depth < 0 || channels == 0) {
+                std::cout << "FrameStream: format cannot be encoded as an image" << std::endl;
+                return;
+            }
+            cv::Mat image(frame.height, frame.width, CV_MAKETYPE(depth, channels), (void *)frame.pixels.data());
+            cv::Mat flipped;
+            cv::flip(image, flipped, 0);
+            if (channels == 3) {
+                cv::cvtColor(flipped, flipped, cv::COLOR_RGB2BGR);
+            }
+            else if (channels == 4) {
+                cv::cvtColor(flipped, flipped, cv::COLOR_RGBA2BGRA);
+            }
+            cv::imwrite(frame_path(pattern, frame.index), flipped);
+        };
+    }
+
+    // Writes the pixels exactly as read back, bottom row first.
+    static Encoder raw_writer(const std::string &pattern) {
+        return [pattern](const Frame &frame) {
+            std::ofstream file(frame_path(pattern, frame.index), std::ios::binary);
+            file.write((const char *)frame.pixels.data(), (std::streamsize)frame.pixels.size());
+        };
+    }
+
+private:
+    struct Slot {
+        globjects::ref_ptr<globjects::Buffer> buffer;
+        gl::GLsync fence;
+        size_t capacity;
+        size_t size;
+        size_t index;
+        int width;
+        int height;
+        gl::GLenum type;
+    };
+
+    void retire(Slot &slot) {
+        gl::glClientWaitSync(slot.fence, gl::GL_SYNC_FLUSH_COMMANDS_BIT, gl::GL_TIMEOUT_IGNORED);
+        gl::glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+
+        Frame *frame;
+        if (!m_free.try_pop(frame)) {
+            ++m_producer_stalls;
+            do {
+                std::this_thread::yield();
+            } while (!m_free.try_pop(frame));
+        }
+
+        frame->index = slot.index;
+        frame->width = slot.width;
+        frame->height = slot.height;
+        frame->type = slot.type;
+        frame->pixels.resize(slot.size);
+        const void *data = slot.buffer->mapRange(0, (gl::GLsizeiptr)slot.size, gl::GL_MAP_READ_BIT);
+        std::memcpy(frame->pixels.data(), data, slot.size);
+        slot.buffer->unmap();
+
+        m_ready.try_push(frame);
+    }
+
+    void work() {
+        Frame *frame;
+        for (;;) {
+            // Read the flag before popping: finish() sets it only after the
+            // last frame is queued, so a failed pop after that means drained.
+            bool stopping = m_stopping;
+            if (m_ready.try_pop(frame)) {
+                m_encoder(*frame);
+                ++m_frames_encoded;
+                m_free.try_push(frame);
+            }
+            else if (stopping) {
+                break;
+            }
+            else {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+    }
+
+    static std::string frame_path(const std::string &pattern, size_t index) {
+        std::vector<char> path(pattern.size() + 32);
+        std::snprintf(path.data(), path.size(), pattern.c_str(), index);
+        return path.data();
+    }
+
+    static int gl_channels(gl::GLenum format) {
+        switch (format) {
+        case gl::GL_RED:
+        case gl::GL_DEPTH_COMPONENT:
+            return 1;
+        case gl::GL_RG:
+            return 2;
+        case gl::GL_RGB:
+            return 3;
+        case gl::GL_RGBA:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    static int cv_depth(gl::GLenum type) {
+        switch (type) {
+        case gl::GL_UNSIGNED_BYTE:
+            return CV_8U;
+        case gl::GL_UNSIGNED_SHORT:
+            return CV_16U;
+        case gl::GL_FLOAT:
+            return CV_32F;
+        default:
+            return -1;
+        }
+    }
+
+    Encoder m_encoder;
+
+    std::vector<Slot> m_ring;
+    size_t m_next_slot;
+
+    std::vector<std::unique_ptr<Frame>> m_frames;
+    BoundedQueue<Frame *> m_free;
+    BoundedQueue<Frame *> m_ready;
+    std::vector<std::thread> m_workers;
+    std::atomic<bool> m_stopping;
+
+    size_t m_frames_pushed;
+    std::atomic<size_t> m_frames_encoded;
+    size_t m_producer_stalls;
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::time_point m_end;
+};
+
+// Uploads buffers and textures on a background thread with its own context
+// sharing objects with the render context. Each upload returns a ticket; the
+// render thread polls ready() and then uses the object like any other. Fences
+// are created, polled and deleted only on the loader thread, so a ticket can
+// be dropped on any thread.
+class AsyncLoader {
+public:
+    class Upload {
+    public:
+        Upload() : m_ready(false), m_fence(nullptr) {}
+
+        // Non-blocking, makes no GL calls.
+        bool ready() const {
+            return m_ready.load(std::memory_order_acquire);
+        }
+
+        void wait() const {
+            while (!ready()) {
+                std::this_thread::yield();
+            }
+        }
+
+        globjects::ref_ptr<globjects::Buffer> buffer() const {
+            return m_buffer;
+        }
+
+        globjects::ref_ptr<globjects::Texture> texture() const {
+            return m_texture;
+        }
+
+    private:
+        friend class AsyncLoader;
+
+        std::atomic<bool> m_ready;
+        // Only touched by the loader thread.
+        gl::GLsync m_fence;
+        globjects::ref_ptr<globjects::Buffer> m_buffer;
+        globjects::ref_ptr<globjects::Texture> m_texture;
+    };
+
+    // Call on the render thread with its context current. Throws if the
+    // loader context cannot share objects with it.
+    explicit AsyncLoader(const HeadlessGL &context, size_t queue_capacity = 64) : m_jobs(queue_capacity) {
+        m_context = std::make_unique<HeadlessGL>(&context);
+        m_stopping = false;
+        m_thread = std::thread(&AsyncLoader::work, this);
+    }
+
+    ~AsyncLoader() {
+        m_stopping = true;
+        m_thread.join();
+    }
+
+    template <typename T>
+    std::shared_ptr<Upload> upload_buffer(std::vector<T> data, gl::GLenum usage = gl::GL_STATIC_DRAW) {
+        std::shared_ptr<std::vector<T>> owned = std::make_shared<std::vector<T>>(std::move(data));
+        std::shared_ptr<Upload> upload = std::make_shared<Upload>();
+        submit([upload, owned, usage]() {
+            upload->m_buffer = globjects::make_ref<globjects::Buffer>();
+            upload->m_buffer->setData(*owned, usage);
+            std::vector<T>().swap(*owned);
+        }, upload);
+        return upload;
+    }
+
+    // The caller keeps data alive until the upload is ready, e.g. a mapped MeshFile.
+    std::shared_ptr<Upload> upload_buffer(const void *data, size_t size, gl::GLenum usage = gl::GL_STATIC_DRAW) {
+        std::shared_ptr<Upload> upload = std::make_shared<Upload>();
+        submit([upload, data, size, usage]() {
+            upload->m_buffer = globjects::make_ref<globjects::Buffer>();
+            upload->m_buffer->setData((gl::GLsizeiptr)size, data, usage);
+        }, upload);
+        return upload;
+    }
+
+    // texels holds width * height values of T, bottom row first.
+    template <typename T>
+    std::shared_ptr<Upload> upload_texture(int width, int height, std::vector<T> texels) {
+        std::shared_ptr<std::vector<T>> owned = std::make_shared<std::vector<T>>(std::move(texels));
+        std::shared_ptr<Upload> upload = std::make_shared<Upload>();
+        submit([upload, owned, width, height]() {
+            gl::GLenum type = GLTypeTraits<T>::color_enum();
+            GLPixelFormat format = pixel_format(type);
+            upload->m_texture = globjects::make_ref<globjects::Texture>(gl::GL_TEXTURE_2D);
+            upload->m_texture->storage2D(1, type, width, height);
+            upload->m_texture->setParameter(gl::GL_TEXTURE_MIN_FILTER, gl::GL_NEAREST);
+            upload->m_texture->setParameter(gl::GL_TEXTURE_MAG_FILTER, gl::GL_NEAREST);
+            gl::glPixelStorei(gl::GL_UNPACK_ALIGNMENT, 1);
+            upload->m_texture->subImage2D(0, 0, 0, width, height, format.format, format.type, owned->data());
+            std::vector<T>().swap(*owned);
+        }, upload);
+        return upload;
+    }
+
+private:
+    struct Job {
+        std::function<void()> run;
+        std::shared_ptr<Upload> upload;
+    };
+
+    void submit(std::function<void()> run, std::shared_ptr<Upload> upload) {
+        Job job;
+        job.run = std::move(run);
+        job.upload = std::move(upload);
+        while (!m_jobs.try_push(job)) {
+            std::this_thread::yield();
+        }
+    }
+
+    void work() {
+        m_context->make_current();
+        globjects::init();
+        Job job;
+        for (;;) {
+            retire_fences();
+            // Read the flag before popping so jobs submitted before the
+            // destructor set it are still run (and fenced) before exiting.
+            bool stopping = m_stopping;
+            if (m_jobs.try_pop(job)) {
+                job.run();
+                job.upload->m_fence = gl::glFenceSync(gl::GL_SYNC_GPU_COMMANDS_COMPLETE, gl::GL_UNUSED_BIT);
+                gl::glFlush();
+                m_in_flight.push_back(std::move(job.upload));
+                job = Job();
+            }
+            else if (stopping) {
+                break;
+            }
+            else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        // Every fence must be deleted while this context is still current.
+        gl::glFinish();
+        retire_fences();
+        m_context->make_other();
+    }
+
+    // Publishes finished uploads and deletes their fences.
+    void retire_fences() {
+        for (size_t i = 0; i < m_in_flight.size();) {
+            Upload &upload = *m_in_flight[i];
+            gl::GLenum status = gl::glClientWaitSync(upload.m_fence, gl::GL_NONE_BIT, 0);
+            if (status == gl::GL_ALREADY_SIGNALED || status == gl::GL_CONDITION_SATISFIED) {
+                gl::glDeleteSync(upload.m_fence);
+                upload.m_fence = nullptr;
+                upload.m_ready.store(true, std::memory_order_release);
+                m_in_flight[i] = std::move(m_in_flight.back());
+                m_in_flight.pop_back();
+            }
+            else {
+                ++i;
+            }
+        }
+    }
+
+    std::unique_ptr<HeadlessGL> m_context;
+    BoundedQueue<Job> m_jobs;
+    std::vector<std::shared_ptr<Upload>> m_in_flight;
+    std::thread m_thread;
+    std::atomic<bool> m_stopping;
 };
 
 class Renderer {
@@ -401,14 +1800,394 @@ public:
         return m_passes[i].get();
     }
 
+    // Streaming mode: after each frame of the given pass, stream_frame()
+    // queues the attachment for encoding without waiting for the readback.
+    void begin_stream(size_t pass, size_t attachment, FrameStream::Encoder encoder, size_t n_workers = 2) {
+        m_stream_pass = pass;
+        m_stream_attachment = attachment;
+        m_stream = std::make_unique<FrameStream>(encoder, n_workers);
+    }
+
+    void stream_frame() {
+        m_stream->push(m_passes[m_stream_pass].get(), m_stream_attachment);
+    }
+
+    FrameStream::Stats end_stream() {
+        m_stream->finish();
+        FrameStream::Stats stats = m_stream->stats();
+        m_stream = nullptr;
+        return stats;
+    }
+
 private:
     std::vector<std::unique_ptr<Pass>> m_passes;
+
+    std::unique_ptr<FrameStream> m_stream;
+    size_t m_stream_pass;
+    size_t m_stream_attachment;
+};
+
+// Renders scenes through their Pass, compares the attachments in their
+// native formats against golden RawImageFiles and times each scene. Meant
+// to run headless on a fixed software rasterizer (e.g. Mesa llvmpipe as the
+// system OpenGL) so the goldens are reproducible across machines.
+class RegressionSuite {
+public:
+    struct Scene {
+        std::string name;
+        Pass *pass;
+        int width;
+        int height;
+        std::function<void()> draw;
+        // Color attachment indices, or Pass::depth_output.
+        std::vector<int> outputs;
+    };
+
+    struct Result {
+        std::string name;
+        // False only when an output differs from its golden or cannot be read.
+        bool passed;
+        // Outputs compared, and outputs skipped for lack of a golden.
+        size_t compared;
+        size_t missing;
+        size_t mismatches;
+        double max_error;
+        double milliseconds;
+        std::string message;
+    };
+
+    explicit RegressionSuite(const std::string &golden_dir, bool update = false) {
+        m_golden_dir = golden_dir;
+        m_update = update;
+    }
+
+    void add_scene(const std::string &name, Pass *pass, int width, int height, std::function<void()> draw, const std::vector<int> &outputs) {
+        Scene scene;
+        scene.name = name;
+        scene.pass = pass;
+        scene.width = width;
+        scene.height = height;
+        scene.draw = draw;
+        scene.outputs = outputs;
+        m_scenes.push_back(scene);
+    }
+
+    // Each scene is rendered once to warm up, then timed over repetitions
+    // frames, each ended with glFinish; the median is reported. With update
+    // set, the goldens are rewritten instead of compared.
+    std::vector<Result> run(size_t repetitions = 5) {
+        std::vector<Result> results;
+        for (Scene &scene : m_scenes) {
+            Result result;
+            result.name = scene.name;
+            result.passed = true;
+            result.compared = 0;
+            result.missing = 0;
+            result.mismatches = 0;
+            result.max_error = 0.0;
+            result.milliseconds = time_scene(scene, repetitions);
+
+            for (int output : scene.outputs) {
+                compare_output(scene, output, result);
+            }
+            results.push_back(result);
+        }
+        return results;
+    }
+
+    // Prints one line per scene; true unless a scene failed. Scenes without
+    // goldens are reported as NOT RUN and do not fail the suite.
+    static bool report(const std::vector<Result> &results) {
+        bool passed = true;
+        for (const Result &result : results) {
+            const char *status = !result.passed ? "FAIL" : result.compared == 0 && result.missing > 0 ? "NOT RUN" : "PASS";
+            std::printf("%-32s %-7s %10.3f ms  %zu mismatches, max error %g%s%s\n",
+                result.name.c_str(), status, result.milliseconds,
+                result.mismatches, result.max_error, result.message.empty() ? "" : "  ", result.message.c_str());
+            passed = passed && result.passed;
+        }
+        return passed;
+    }
+
+    // Largest accepted per-component difference for a pixel format: exact for
+    // integer and packed formats, one step for normalized ones, relative for
+    // floating point.
+    static double tolerance(const GLPixelFormat &format) {
+        if (is_integer_format(format.format)) {
+            return 0.0;
+        }
+        switch (format.type) {
+        case gl::GL_FLOAT:
+            return 1e-5;
+        case gl::GL_HALF_FLOAT:
+            return 1e-3;
+        case gl::GL_UNSIGNED_INT:
+            // 24-bit depth is returned in the high bits of 32.
+            return format.format == gl::GL_DEPTH_COMPONENT ? 256.0 : 1.0;
+        case gl::GL_UNSIGNED_INT_10F_11F_11F_REV:
+        case gl::GL_UNSIGNED_INT_2_10_10_10_REV:
+            return 0.0;
+        default:
+            return 1.0;
+        }
+    }
+
+private:
+    double time_scene(Scene &scene, size_t repetitions) {
+        render(scene);
+        gl::glFinish();
+        std::vector<double> times;
+        for (size_t i = 0; i < repetitions; ++i) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            render(scene);
+            gl::glFinish();
+            times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        if (times.empty()) {
+            return 0.0;
+        }
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+
+    // Leaves the framebuffer contents of the last frame for readback.
+    static void render(Scene &scene) {
+        scene.pass->begin(scene.width, scene.height);
+        scene.draw();
+        scene.pass->end();
+    }
+
+    void compare_output(Scene &scene, int output, Result &result) {
+        gl::GLenum type = output == Pass::depth_output ? scene.pass->depth_attachment_type() : scene.pass->color_attachment_type((size_t)output);
+        std::string path = m_golden_dir + "/" + scene.name + "_" + (output == Pass::depth_output ? std::string("depth") : std::to_string(output)) + ".glri";
+
+        if (m_update) {
+            RawImageFile golden;
+            if (!golden.create(path, scene.width, scene.height, type)) {
+                fail(result, "cannot write " + path);
+                return;
+            }
+            read_output(scene, output, golden.frame(0));
+            result.message += "updated " + path + " ";
+            return;
+        }
+
+        RawImageFile golden;
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0) {
+            ++result.missing;
+            result.message += "no golden " + path + " (run with --update) ";
+            return;
+        }
+        if (!golden.open(path)) {
+            fail(result, "cannot read golden " + path);
+            return;
+        }
+        if (golden.width() != scene.width || golden.height() != scene.height || golden.format() != type) {
+            fail(result, "size or format differs from " + path);
+            return;
+        }
+        std::vector<char> pixels(golden.frame_size());
+        read_output(scene, output, pixels.data());
+        ++result.compared;
+
+        GLPixelFormat format = pixel_format(type);
+        double max_error = 0.0;
+        size_t mismatches = compare(format, pixels.data(), golden.frame(0), golden.frame_size(), max_error);
+        result.mismatches += mismatches;
+        result.max_error = std::max(result.max_error, max_error);
+        if (mismatches > 0) {
+            fail(result, "differs from " + path);
+        }
+    }
+
+    static void read_output(Scene &scene, int output, void *data) {
+        if (output == Pass::depth_output) {
+            scene.pass->read_depth_attachment(data);
+        }
+        else {
+            scene.pass->read_color_attachment((size_t)output, data);
+        }
+    }
+
+    static void fail(Result &result, const std::string &message) {
+        result.passed = false;
+        result.message += message + " ";
+    }
+
+    // Counts components differing by more than tolerance(format).
+    static size_t compare(const GLPixelFormat &format, const void *actual, const void *expected, size_t size, double &max_error) {
+        double limit = tolerance(format);
+        size_t mismatches = 0;
+        max_error = 0.0;
+        switch (format.type) {
+        case gl::GL_FLOAT:
+            return compare_components<float>(actual, expected, size, limit, true, max_error);
+        case gl::GL_HALF_FLOAT: {
+            const std::uint16_t *a = (const std::uint16_t *)actual;
+            const std::uint16_t *e = (const std::uint16_t *)expected;
+            for (size_t i = 0; i < size / sizeof(std::uint16_t); ++i) {
+                double x = glm::unpackHalf1x16(a[i]);
+                double y = glm::unpackHalf1x16(e[i]);
+                double error = std::abs(x - y) / std::max(1.0, std::abs(y));
+                max_error = std::max(max_error, error);
+                mismatches += error > limit ? 1 : 0;
+            }
+            return mismatches;
+        }
+        case gl::GL_BYTE:
+            return compare_components<std::int8_t>(actual, expected, size, limit, false, max_error);
+        case gl::GL_UNSIGNED_BYTE:
+            return compare_components<std::uint8_t>(actual, expected, size, limit, false, max_error);
+        case gl::GL_SHORT:
+            return compare_components<std::int16_t>(actual, expected, size, limit, false, max_error);
+        case gl::GL_UNSIGNED_SHORT:
+            return compare_components<std::uint16_t>(actual, expected, size, limit, false, max_error);
+        case gl::GL_INT:
+            return compare_components<std::int32_t>(actual, expected, size, limit, false, max_error);
+        default:
+            return compare_components<std::uint32_t>(actual, expected, size, limit, false, max_error);
+        }
+    }
+
+    template <typename T>
+    static size_t compare_components(const void *actual, const void *expected, size_t size, double limit, bool relative, double &max_error) {
+        const T *a = (const T *)actual;
+        const T *e = (const T *)expected;
+        size_t mismatches = 0;
+        for (size_t i = 0; i < size / sizeof(T); ++i) {
+            double x = (double)a[i];
+            double y = (double)e[i];
+            double error = std::abs(x - y);
+            if (relative) {
+                error /= std::max(1.0, std::abs(y));
+            }
+            // NaN never compares greater, count it explicitly.
+            bool mismatch = error > limit || (x != x) != (y != y);
+            max_error = std::max(max_error, error);
+            mismatches += mismatch ? 1 : 0;
+        }
+        return mismatches;
+    }
+
+    static bool is_integer_format(gl::GLenum format) {
+        return format == gl::GL_RED_INTEGER || format == gl::GL_RG_INTEGER
+            || format == gl::GL_RGB_INTEGER || format == gl::GL_RGBA_INTEGER;
+    }
+
+    std::string m_golden_dir;
+    bool m_update;
+    std::vector<Scene> m_scenes;
 };
 
 
 
 #define glsl_main(source) "" # source
 
+GLSL_NAME(vertex_coord);
+GLSL_NAME(frag_color);
+
+typedef ShaderLayout<
+    vshader_input<0, glm::vec3, vertex_coord>,
+    fshader_output<glm::vec4, frag_color>
+> TriangleLayout;
+
+#ifdef GLRENDERER_REGRESSION
+
+GLSL_NAME(frag_id);
+
+typedef ShaderLayout<
+    vshader_input<0, glm::vec3, vertex_coord>,
+    fshader_output<std::uint32_t, frag_id>
+> IntegerLayout;
+
+typedef ShaderLayout<
+    vshader_input<0, glm::vec3, vertex_coord>,
+    fshader_output<hvec4, frag_color>
+> HalfLayout;
+
+typedef ShaderLayout<
+    vshader_input<0, glm::vec3, vertex_coord>,
+    fshader_output<normalized<glm::u8vec4>, frag_color>
+> NormalizedLayout;
+
+// Built by the GLRendererRegression project. One scene per output family:
+// float color with 32-bit float depth, R32UI, RGBA16F, and RGBA8 with
+// 24-bit depth.
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cout << "usage: GLRendererRegression <golden dir> [--update]" << std::endl;
+        return 2;
+    }
+    HeadlessGL gl;
+    gl.make_current();
+    globjects::init();
+
+    // Depth varies across the triangle so the depth goldens cover interpolation.
+    std::unique_ptr<Geometry> triangle = std::make_unique<Geometry>();
+    std::vector<glm::vec3> points;
+    points.emplace_back(-0.9f, -0.9f, -0.5f);
+    points.emplace_back(0.9f, -0.7f, 0.2f);
+    points.emplace_back(-0.1f, 0.9f, 0.8f);
+    triangle->add_attribute<TriangleLayout, 0>(points);
+
+    // Clearing integer attachments with glClear is undefined, so the integer
+    // scene covers every pixel.
+    std::unique_ptr<Geometry> fullscreen = std::make_unique<Geometry>();
+    std::vector<glm::vec3> corners;
+    corners.emplace_back(-1.0f, -1.0f, 0.0f);
+    corners.emplace_back(3.0f, -1.0f, 0.0f);
+    corners.emplace_back(-1.0f, 3.0f, 0.0f);
+    fullscreen->add_attribute<IntegerLayout, 0>(corners);
+
+    std::unique_ptr<Renderer> renderer = std::make_unique<Renderer>();
+    renderer->set_n_passes(4);
+    const char *vshader = glsl_main(
+        gl_Position = vec4(vertex_coord, 1.0f);
+    );
+
+    Pass *float_pass = renderer->pass(0);
+    float_pass->set_layout<TriangleLayout>();
+    float_pass->add_depth_attachment(gl::GL_DEPTH_COMPONENT32F);
+    float_pass->set_shader(vshader, glsl_main(
+        frag_color = vec4(gl_FragCoord.xy / vec2(256.0f, 192.0f), gl_FragCoord.z, 1.0f);
+    ));
+
+    Pass *integer_pass = renderer->pass(1);
+    integer_pass->set_layout<IntegerLayout>();
+    integer_pass->set_shader(vshader, glsl_main(
+        frag_id = uint(gl_FragCoord.y) * 65536u + uint(gl_FragCoord.x);
+    ));
+
+    Pass *half_pass = renderer->pass(2);
+    half_pass->set_layout<HalfLayout>();
+    half_pass->set_shader(vshader, glsl_main(
+        frag_color = vec4(gl_FragCoord.xy / vec2(256.0f, 192.0f), 0.25f, 1.0f);
+    ));
+
+    Pass *normalized_pass = renderer->pass(3);
+    normalized_pass->set_layout<NormalizedLayout>();
+    normalized_pass->add_depth_attachment(gl::GL_DEPTH_COMPONENT24);
+    normalized_pass->set_shader(vshader, glsl_main(
+        frag_color = vec4(gl_FragCoord.xy / vec2(256.0f, 192.0f), 0.25f, 1.0f);
+    ));
+
+    for (size_t i = 0; i < renderer->n_passes(); ++i) {
+        renderer->pass(i)->state()->enable(gl::GL_DEPTH_TEST);
+        renderer->pass(i)->state()->clearColor({0.0f, 0.0f, 0.0f, 0.0f});
+        renderer->pass(i)->state()->clearDepth(1.0f);
+    }
+
+    RegressionSuite suite(argv[1], argc >= 3 && std::string(argv[2]) == "--update");
+    suite.add_scene("float_depth32f", float_pass, 256, 192, [&]() { triangle->draw(); }, { 0, Pass::depth_output });
+    suite.add_scene("integer_r32ui", integer_pass, 256, 192, [&]() { fullscreen->draw(); }, { 0 });
+    suite.add_scene("half_rgba16f", half_pass, 256, 192, [&]() { triangle->draw(); }, { 0 });
+    suite.add_scene("normalized_rgba8_depth24", normalized_pass, 256, 192, [&]() { triangle->draw(); }, { 0, Pass::depth_output });
+    return RegressionSuite::report(suite.run()) ? 0 : 1;
+}
+
+#else
+
 int main(int argc, char *argv[]) {
     HeadlessGL gl;
     gl.make_current();
@@ -421,11 +2200,10 @@ int main(int argc, char *argv[]) {
     points.emplace_back(0.0f, 0.0f, 0.5f);
     points.emplace_back(0.0f, 1.0f, 0.5f);
     points.emplace_back(1.0f, 0.0f, 0.5f);
-    geometry->add_attribute(points);
+    geometry->add_attribute<TriangleLayout, 0>(points);
 
     renderer->set_n_passes(1);
-    renderer->pass(0)->add_vshader_input<glm::vec3>(0, "vertex_coord");
-    renderer->pass(0)->add_color_attachment<glm::vec4>("frag_color");
+    renderer->pass(0)->set_layout<TriangleLayout>();
     renderer->pass(0)->set_shader(
         glsl_main(
             gl_Position = vec4(vertex_coord, 1.0f);
@@ -436,12 +2214,23 @@ int main(int argc, char *argv[]) {
     );
     renderer->pass(0)->state()->clearColor({0.0f, 0.0f, 0.0f, 0.0f});
     renderer->pass(0)->state()->clearDepth(1.0f);
+
     renderer->pass(0)->begin(640, 480);
 
-    geometry->bind_attribute_input(0, 0);
     geometry->draw();
 
     renderer->pass(0)->end();
+
+#ifdef GLRENDERER_COUNT_ALLOCATIONS
+    size_t allocations = allocation_count();
+    renderer->pass(0)->begin(640, 480);
+    geometry->draw();
+    renderer->pass(0)->end();
+    std::cout << "Allocations per frame: " << allocation_count() - allocations << std::endl;
+#endif
+
     renderer->pass(0)->show_color_attachment(0);
     return 0;
 }
+
+#endif